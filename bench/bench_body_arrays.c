@@ -0,0 +1,143 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_util.h"
+#include "scene.h"
+
+/**
+ * Compares the scene's batched integration with ticking each body on its
+ * own, to check that gathering bodies into the scene's parallel arrays and
+ * writing the results back pays for itself.
+ * - before: body_tick() on every body, as scene_tick() used to do.
+ * - after: scene_tick(), which gathers the bodies' state into arrays, runs
+ *   integrator_step() over them, and writes them back with body_advance().
+ * Every body gets a force each tick and some get impulses, and a few have
+ * infinite mass. Exits with an error if the two ever disagree on a body's
+ * position or velocity, bit for bit.
+ *
+ * Usage: bench_body_arrays [max bodies] [ticks]
+ */
+
+const size_t MIN_BODIES = 1000;
+const size_t DEFAULT_MAX_BODIES = 64000;
+const size_t BODIES_FACTOR = 4;
+const size_t DEFAULT_TICKS = 100;
+const double DT = 1.0 / 240;
+const vector_t GRAVITY = {0, -500};
+const vector_t LAUNCH_VELOCITY = {400, 300};
+// every IMPULSE_SPACING-th body gets an impulse each tick
+const size_t IMPULSE_SPACING = 7;
+const vector_t IMPULSE = {-3, 5};
+// every INFINITE_MASS_SPACING-th body has infinite mass
+const size_t INFINITE_MASS_SPACING = 101;
+
+/**
+ * Makes the same bodies every time it is called.
+ *
+ * @param bodies filled in with num_bodies new bodies
+ */
+static void make_bodies(body_t **bodies, size_t num_bodies) {
+  for (size_t i = 0; i < num_bodies; i++) {
+    double mass = i % INFINITE_MASS_SPACING == 0 ? INFINITY : 1 + i % 5;
+    bodies[i] = bench_make_rectangle((vector_t){i % 1000, i / 1000}, 1, 1,
+                                     mass);
+    body_set_velocity(bodies[i], vec_multiply(1 + i % 3, LAUNCH_VELOCITY));
+  }
+}
+
+static void add_forces(body_t **bodies, size_t num_bodies) {
+  for (size_t i = 0; i < num_bodies; i++) {
+    body_add_force(bodies[i], vec_multiply(1 + i % 5, GRAVITY));
+    if (i % IMPULSE_SPACING == 0) {
+      body_add_impulse(bodies[i], IMPULSE);
+    }
+  }
+}
+
+/**
+ * Ticks the bodies one at a time.
+ *
+ * @return the number of nanoseconds per body per tick
+ */
+static double time_body_ticks(body_t **bodies, size_t num_bodies,
+                              size_t num_ticks) {
+  double start = bench_now();
+  for (size_t tick = 0; tick < num_ticks; tick++) {
+    add_forces(bodies, num_bodies);
+    for (size_t i = 0; i < num_bodies; i++) {
+      body_tick(bodies[i], DT);
+    }
+  }
+  return (bench_now() - start) / num_ticks / num_bodies * 1e9;
+}
+
+/**
+ * Ticks the bodies in a scene.
+ *
+ * @return the number of nanoseconds per body per tick
+ */
+static double time_scene_ticks(scene_t *scene, body_t **bodies,
+                               size_t num_bodies, size_t num_ticks) {
+  double start = bench_now();
+  for (size_t tick = 0; tick < num_ticks; tick++) {
+    add_forces(bodies, num_bodies);
+    scene_tick(scene, DT);
+  }
+  return (bench_now() - start) / num_ticks / num_bodies * 1e9;
+}
+
+/**
+ * Counts the bodies whose position or velocity is not bit for bit the same
+ * in two sets of bodies.
+ */
+static size_t count_mismatches(body_t **bodies, body_t **expected,
+                               size_t num_bodies) {
+  size_t mismatches = 0;
+  for (size_t i = 0; i < num_bodies; i++) {
+    vector_t centers[] = {body_get_centroid(bodies[i]),
+                          body_get_centroid(expected[i])};
+    vector_t velocities[] = {body_get_velocity(bodies[i]),
+                             body_get_velocity(expected[i])};
+    if (memcmp(&centers[0], &centers[1], sizeof(vector_t)) != 0 ||
+        memcmp(&velocities[0], &velocities[1], sizeof(vector_t)) != 0) {
+      mismatches++;
+    }
+  }
+  return mismatches;
+}
+
+int main(int argc, char **argv) {
+  size_t max_bodies = bench_arg(argc, argv, 1, DEFAULT_MAX_BODIES);
+  size_t num_ticks = bench_arg(argc, argv, 2, DEFAULT_TICKS);
+  size_t total_mismatches = 0;
+
+  printf("%8s %18s %18s %8s %11s\n", "bodies", "body_tick (ns)",
+         "scene_tick (ns)", "speedup", "mismatches");
+  for (size_t n = MIN_BODIES; n <= max_bodies; n *= BODIES_FACTOR) {
+    body_t **before = malloc(n * sizeof(body_t *));
+    body_t **after = malloc(n * sizeof(body_t *));
+    make_bodies(before, n);
+    make_bodies(after, n);
+    scene_t *scene = scene_init();
+    for (size_t i = 0; i < n; i++) {
+      scene_add_body(scene, after[i]);
+    }
+
+    double body_tick_time = time_body_ticks(before, n, num_ticks);
+    double scene_tick_time = time_scene_ticks(scene, after, n, num_ticks);
+    size_t mismatches = count_mismatches(after, before, n);
+    printf("%8zu %18.1f %18.1f %7.2fx %11zu\n", n, body_tick_time,
+           scene_tick_time, body_tick_time / scene_tick_time, mismatches);
+    total_mismatches += mismatches;
+
+    for (size_t i = 0; i < n; i++) {
+      body_free(before[i]);
+    }
+    scene_free(scene);
+    free(before);
+    free(after);
+  }
+  return total_mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
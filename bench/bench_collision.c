@@ -0,0 +1,132 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_util.h"
+#include "collision.h"
+
+/**
+ * Times find_collision() on its rectangle fast paths against the general
+ * separating axis test, and checks that they agree.
+ * A rectangle with an extra vertex in the middle of one side has the same
+ * shape, but is not recognized as a rectangle, so it takes the general path.
+ *
+ * Usage: bench_collision [iterations] [pairs]
+ */
+
+const size_t DEFAULT_ITERATIONS = 10000000;
+const size_t DEFAULT_PAIRS = 200000;
+const unsigned int SEED = 24;
+// random rectangles are centered in [-RANGE, RANGE] on both axes
+const double RANGE = 10;
+const double MIN_SIDE = 1;
+const double MAX_SIDE = 8;
+
+/**
+ * Allocates a rectangle with a fifth vertex in the middle of its top side.
+ */
+static body_t *make_generic_rectangle(vector_t center, double width,
+                                      double height) {
+  vector_t shape[] = {{center.x - width / 2, center.y - height / 2},
+                      {center.x + width / 2, center.y - height / 2},
+                      {center.x + width / 2, center.y + height / 2},
+                      {center.x, center.y + height / 2},
+                      {center.x - width / 2, center.y + height / 2}};
+  return body_init(shape, sizeof(shape) / sizeof(*shape), 1,
+                   (rgb_color_t){0, 0, 0});
+}
+
+static double random_between(double min, double max) {
+  return min + (max - min) * rand() / RAND_MAX;
+}
+
+/**
+ * Tests random pairs of rectangles, half of them rotated, on both paths.
+ *
+ * @return the number of pairs the paths disagree on
+ */
+static size_t count_disagreements(size_t num_pairs) {
+  size_t disagreements = 0;
+  for (size_t i = 0; i < num_pairs; i++) {
+    body_t *boxes[2];
+    body_t *generics[2];
+    for (size_t j = 0; j < 2; j++) {
+      vector_t center = {random_between(-RANGE, RANGE),
+                         random_between(-RANGE, RANGE)};
+      double width = random_between(MIN_SIDE, MAX_SIDE);
+      double height = random_between(MIN_SIDE, MAX_SIDE);
+      double rotation = i % 2 == 0 ? 0 : random_between(0, 2 * M_PI);
+      boxes[j] = bench_make_rectangle(center, width, height, 1);
+      generics[j] = make_generic_rectangle(center, width, height);
+      body_set_rotation(boxes[j], rotation);
+      body_set_rotation(generics[j], rotation);
+    }
+    if (find_collision(boxes[0], boxes[1]).collided !=
+        find_collision(generics[0], generics[1]).collided) {
+      disagreements++;
+    }
+    for (size_t j = 0; j < 2; j++) {
+      body_free(boxes[j]);
+      body_free(generics[j]);
+    }
+  }
+  return disagreements;
+}
+
+/**
+ * Times repeated collision tests between two bodies.
+ *
+ * @return the number of seconds the tests took
+ */
+static double time_pair(body_t *body1, body_t *body2, size_t iterations) {
+  volatile size_t collisions = 0;
+  double start = bench_now();
+  for (size_t i = 0; i < iterations; i++) {
+    collisions += find_collision(body1, body2).collided;
+  }
+  return bench_now() - start;
+}
+
+/**
+ * Times a pair of rectangles on the fast path and on the general path,
+ * and prints both with the path the fast pair actually took.
+ */
+static void compare_paths(const char *name, double rotation,
+                          size_t iterations) {
+  vector_t center1 = {0, 0};
+  vector_t center2 = {5, 5};
+  body_t *box1 = bench_make_rectangle(center1, 10, 4, 1);
+  body_t *box2 = bench_make_rectangle(center2, 10, 10, 1);
+  body_t *generic1 = make_generic_rectangle(center1, 10, 4);
+  body_t *generic2 = make_generic_rectangle(center2, 10, 10);
+  body_set_rotation(box1, rotation);
+  body_set_rotation(generic1, rotation);
+
+  collision_reset_stats();
+  double fast = time_pair(box1, box2, iterations);
+  collision_stats_t stats = collision_get_stats();
+  double generic = time_pair(generic1, generic2, iterations);
+  printf("%-12s fast path %6.3f s  general path %6.3f s  (%.1fx; %zu aabb, "
+         "%zu box tests)\n",
+         name, fast, generic, generic / fast, stats.aabb_tests,
+         stats.box_tests);
+
+  body_free(box1);
+  body_free(box2);
+  body_free(generic1);
+  body_free(generic2);
+}
+
+int main(int argc, char **argv) {
+  size_t iterations = bench_arg(argc, argv, 1, DEFAULT_ITERATIONS);
+  size_t num_pairs = bench_arg(argc, argv, 2, DEFAULT_PAIRS);
+  srand(SEED);
+
+  size_t disagreements = count_disagreements(num_pairs);
+  printf("%zu of %zu random rectangle pairs disagree\n", disagreements,
+         num_pairs);
+  printf("%zu collision tests per pair:\n", iterations);
+  compare_paths("aabb-aabb", 0, iterations);
+  compare_paths("obb-aabb", 0.5, iterations);
+  return disagreements == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,172 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_util.h"
+#include "forces.h"
+#include "integrator.h"
+#include "scene.h"
+
+/**
+ * Compares the accuracy and cost of the scene's integrators.
+ * - An arrow under constant gravity is flown for its whole flight at three
+ *   tick lengths, and its landing point compared with the exact parabola.
+ * - A body on a unit spring is run for ten periods, and its amplitude and
+ *   phase compared with the exact oscillation.
+ * - Many bodies under gravity are ticked to time each integrator.
+ * Exits with an error if a scheme that should be exact for constant forces
+ * misses the landing point.
+ *
+ * Usage: bench_integrators [bodies] [ticks]
+ */
+
+enum { NUM_INTEGRATORS = 4, NUM_DTS = 3 };
+
+const char *const INTEGRATOR_NAMES[NUM_INTEGRATORS] = {
+    [INTEGRATOR_AVERAGE_VELOCITY] = "average",
+    [INTEGRATOR_SEMI_IMPLICIT_EULER] = "semi-implicit Euler",
+    [INTEGRATOR_VELOCITY_VERLET] = "velocity Verlet",
+    [INTEGRATOR_CONSTANT_ACCELERATION] = "constant accel"};
+// whether a scheme is exact when the force is constant over a tick
+const bool EXACT_FOR_CONSTANT_FORCE[NUM_INTEGRATORS] = {
+    [INTEGRATOR_AVERAGE_VELOCITY] = true,
+    [INTEGRATOR_SEMI_IMPLICIT_EULER] = false,
+    [INTEGRATOR_VELOCITY_VERLET] = true,
+    [INTEGRATOR_CONSTANT_ACCELERATION] = true};
+const double DTS[NUM_DTS] = {1.0 / 240, 1.0 / 60, 1.0 / 15};
+const double MAX_EXACT_ERROR = 1e-6;
+
+const vector_t GRAVITY = {0, -500};
+const vector_t LAUNCH_VELOCITY = {400, 300};
+const double MASS = 10;
+
+const double SPRING_AMPLITUDE = 100;
+const double SPRING_DT = 1.0 / 60;
+const size_t SPRING_PERIODS = 10;
+
+const size_t DEFAULT_BODIES = 20000;
+const size_t DEFAULT_TICKS = 200;
+
+/**
+ * Flies an arrow from the origin until it is back at height 0.
+ *
+ * @return the distance from the exact landing point
+ */
+static double landing_error(integrator_t integrator, double dt) {
+  double flight_time = -2 * LAUNCH_VELOCITY.y / GRAVITY.y;
+  scene_t *scene = scene_init();
+  scene_set_integrator(scene, integrator);
+  body_t *arrow = bench_make_rectangle(VEC_ZERO, 2, 2, MASS);
+  body_set_velocity(arrow, LAUNCH_VELOCITY);
+  scene_add_body(scene, arrow);
+  size_t ticks = round(flight_time / dt);
+  for (size_t i = 0; i < ticks; i++) {
+    body_add_force(arrow, vec_multiply(MASS, GRAVITY));
+    scene_tick(scene, dt);
+  }
+  vector_t exact = {LAUNCH_VELOCITY.x * flight_time, 0};
+  double error =
+      vec_get_length(vec_subtract(body_get_centroid(arrow), exact));
+  scene_free(scene);
+  return error;
+}
+
+/**
+ * Runs a unit mass on a unit spring to a fixed anchor, starting at rest at
+ * SPRING_AMPLITUDE, so that it should move as SPRING_AMPLITUDE * cos(t).
+ *
+ * @param amplitude set to the final amplitude
+ * @param phase_error set to how far the final phase is from the exact one
+ */
+static void run_spring(integrator_t integrator, double *amplitude,
+                       double *phase_error) {
+  scene_t *scene = scene_init();
+  scene_set_integrator(scene, integrator);
+  body_t *anchor = bench_make_rectangle(VEC_ZERO, 1, 1, INFINITY);
+  body_t *body =
+      bench_make_rectangle((vector_t){SPRING_AMPLITUDE, 0}, 1, 1, 1);
+  scene_add_body(scene, anchor);
+  scene_add_body(scene, body);
+  create_spring(scene, 1, body, anchor);
+  size_t ticks = round(SPRING_PERIODS * 2 * M_PI / SPRING_DT);
+  for (size_t i = 0; i < ticks; i++) {
+    scene_tick(scene, SPRING_DT);
+  }
+  double x = body_get_centroid(body).x;
+  double v = body_get_velocity(body).x;
+  *amplitude = hypot(x, v);
+  // x = A cos(t) and v = -A sin(t), so the phase is atan2(-v, x)
+  double error = atan2(-v, x) - ticks * SPRING_DT;
+  *phase_error = fabs(remainder(error, 2 * M_PI));
+  scene_free(scene);
+}
+
+/**
+ * Times ticks of a scene of bodies under gravity.
+ *
+ * @return the number of nanoseconds per body per tick
+ */
+static double time_ticks(integrator_t integrator, size_t num_bodies,
+                         size_t num_ticks) {
+  scene_t *scene = scene_init();
+  scene_set_integrator(scene, integrator);
+  for (size_t i = 0; i < num_bodies; i++) {
+    body_t *body = bench_make_rectangle((vector_t){i, 0}, 1, 1, MASS);
+    body_set_velocity(body, LAUNCH_VELOCITY);
+    scene_add_body(scene, body);
+  }
+  vector_t weight = vec_multiply(MASS, GRAVITY);
+  double start = bench_now();
+  for (size_t tick = 0; tick < num_ticks; tick++) {
+    for (size_t i = 0; i < num_bodies; i++) {
+      body_add_force(scene_get_body(scene, i), weight);
+    }
+    scene_tick(scene, DTS[0]);
+  }
+  double elapsed = bench_now() - start;
+  scene_free(scene);
+  return elapsed / num_ticks / num_bodies * 1e9;
+}
+
+int main(int argc, char **argv) {
+  size_t num_bodies = bench_arg(argc, argv, 1, DEFAULT_BODIES);
+  size_t num_ticks = bench_arg(argc, argv, 2, DEFAULT_TICKS);
+  bool correct = true;
+
+  printf("landing error (v0 = (%g, %g), g = %g):\n", LAUNCH_VELOCITY.x,
+         LAUNCH_VELOCITY.y, GRAVITY.y);
+  printf("  %-20s", "");
+  for (size_t d = 0; d < NUM_DTS; d++) {
+    char header[sizeof("dt=1/") + 3 * sizeof(int)];
+    snprintf(header, sizeof(header), "dt=1/%.0f", 1 / DTS[d]);
+    printf(" %14s", header);
+  }
+  printf(" %14s\n", "ns/body-tick");
+  for (size_t i = 0; i < NUM_INTEGRATORS; i++) {
+    printf("  %-20s", INTEGRATOR_NAMES[i]);
+    for (size_t d = 0; d < NUM_DTS; d++) {
+      double error = landing_error(i, DTS[d]);
+      printf(" %14.2e", error);
+      if (EXACT_FOR_CONSTANT_FORCE[i] && error > MAX_EXACT_ERROR) {
+        correct = false;
+      }
+    }
+    printf(" %14.1f\n", time_ticks(i, num_bodies, num_ticks));
+  }
+
+  printf("unit spring at dt=1/%.0f over %zu periods (amplitude %g):\n",
+         1 / SPRING_DT, SPRING_PERIODS, SPRING_AMPLITUDE);
+  for (size_t i = 0; i < NUM_INTEGRATORS; i++) {
+    double amplitude, phase_error;
+    run_spring(i, &amplitude, &phase_error);
+    printf("  %-20s amplitude %10.3f  phase error %.3f\n",
+           INTEGRATOR_NAMES[i], amplitude, phase_error);
+  }
+
+  if (!correct) {
+    printf("an exact scheme missed the landing point by more than %g\n",
+           MAX_EXACT_ERROR);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
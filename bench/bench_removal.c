@@ -0,0 +1,114 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_util.h"
+#include "forces.h"
+#include "scene.h"
+
+/**
+ * Times spawning and removing thousands of bodies that have force jobs
+ * attached, to check that removal stays linear in the size of the scene.
+ * Each body gets drag and a spring to one shared anchor, like the level's
+ * bodies get gravity and collisions with the characters.
+ *
+ * Usage: bench_removal [max bodies]
+ */
+
+const size_t MIN_BODIES = 2000;
+const size_t DEFAULT_MAX_BODIES = 16000;
+const size_t REMOVAL_TICKS = 10;
+const size_t CHURN_TICKS = 100;
+// the fraction of the bodies replaced by new ones on each churn tick
+const size_t CHURN_DIVISOR = 10;
+const double DT = 0.01;
+const double DRAG = 0.1;
+const double SPRING_CONSTANT = 0.1;
+
+/**
+ * Adds a body with drag and a spring to the anchor to the scene.
+ */
+static void spawn_body(scene_t *scene, body_t *anchor, size_t index) {
+  body_t *body = bench_make_rectangle((vector_t){index % 100, index / 100},
+                                      1, 1, 1);
+  scene_add_body(scene, body);
+  create_drag(scene, DRAG, body);
+  create_spring(scene, SPRING_CONSTANT, body, anchor);
+}
+
+/**
+ * Makes a scene with an anchor at index 0 and num_bodies bodies after it.
+ */
+static scene_t *make_scene(size_t num_bodies) {
+  scene_t *scene = scene_init();
+  body_t *anchor = bench_make_rectangle(VEC_ZERO, 1, 1, INFINITY);
+  scene_add_body(scene, anchor);
+  for (size_t i = 0; i < num_bodies; i++) {
+    spawn_body(scene, anchor, i);
+  }
+  return scene;
+}
+
+/**
+ * Removes every other body but the anchor each tick.
+ *
+ * @return whether the expected number of bodies is left
+ */
+static bool remove_halves(scene_t *scene, size_t num_bodies) {
+  size_t expected = num_bodies;
+  for (size_t tick = 0; tick < REMOVAL_TICKS; tick++) {
+    for (size_t i = 1; i < scene_bodies(scene); i += 2) {
+      body_remove(scene_get_body(scene, i));
+    }
+    expected -= (expected + 1) / 2;
+    scene_tick(scene, DT);
+  }
+  return scene_bodies(scene) == expected + 1;
+}
+
+/**
+ * Replaces a tenth of the bodies with new ones each tick.
+ *
+ * @return whether the number of bodies stayed the same
+ */
+static bool churn(scene_t *scene, size_t num_bodies) {
+  body_t *anchor = scene_get_body(scene, 0);
+  size_t replaced = num_bodies / CHURN_DIVISOR;
+  for (size_t tick = 0; tick < CHURN_TICKS; tick++) {
+    size_t first = 1 + tick * replaced % (num_bodies - replaced);
+    for (size_t i = first; i < first + replaced; i++) {
+      body_remove(scene_get_body(scene, i));
+    }
+    for (size_t i = 0; i < replaced; i++) {
+      spawn_body(scene, anchor, i);
+    }
+    scene_tick(scene, DT);
+  }
+  return scene_bodies(scene) == num_bodies + 1;
+}
+
+int main(int argc, char **argv) {
+  size_t max_bodies = bench_arg(argc, argv, 1, DEFAULT_MAX_BODIES);
+  bool correct = true;
+  printf("%8s %22s %22s\n", "bodies", "remove half x10 (s)",
+         "replace 10% x100 (s)");
+  for (size_t n = MIN_BODIES; n <= max_bodies; n *= 2) {
+    scene_t *scene = make_scene(n);
+    double start = bench_now();
+    correct = remove_halves(scene, n) && correct;
+    double removal = bench_now() - start;
+    scene_free(scene);
+
+    scene = make_scene(n);
+    start = bench_now();
+    correct = churn(scene, n) && correct;
+    double churn_time = bench_now() - start;
+    scene_free(scene);
+    printf("%8zu %22.4f %22.4f\n", n, removal, churn_time);
+  }
+  if (!correct) {
+    printf("wrong number of bodies left\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_util.h"
+#include "collision.h"
+#include "forces.h"
+#include "scene.h"
+
+/**
+ * Checks continuous collision detection on a fast box that passes right
+ * through a thin wall in one tick, and times the swept test.
+ * - find_collision() must return the time the box first touched the wall,
+ *   and collision_move_to_contact() must put it against the wall.
+ * - With a physics collision in a scene, the box must bounce off the near
+ *   side of the wall instead of from wherever the tick left it.
+ * Exits with an error if any of these is off.
+ *
+ * Usage: bench_swept [iterations]
+ */
+
+enum { NUM_SPEEDS = 3, NUM_GAPS = 3 };
+
+const size_t DEFAULT_ITERATIONS = 10000000;
+const double DT = 1.0 / 60;
+// the box covers 50 to 200 units in a tick, so it ends up past the wall
+const double SPEEDS[NUM_SPEEDS] = {3000, 6000, 12000};
+// how far the box's front starts from the wall
+const double GAPS[NUM_GAPS] = {1, 10, 40};
+const double BOX_SIZE = 2;
+const double WALL_X = 100;
+const double WALL_WIDTH = 0.5;
+const double WALL_HEIGHT = 20;
+const double MAX_ERROR = 1e-9;
+
+/**
+ * Makes a scene with the wall and a continuous box moving towards it.
+ *
+ * @param box set to the box
+ * @param wall set to the wall
+ */
+static scene_t *make_scene(double speed, double gap, body_t **box,
+                           body_t **wall) {
+  scene_t *scene = scene_init();
+  *wall = bench_make_rectangle(
+      (vector_t){WALL_X + WALL_WIDTH / 2, 0}, WALL_WIDTH, WALL_HEIGHT,
+      INFINITY);
+  *box = bench_make_rectangle((vector_t){WALL_X - gap - BOX_SIZE / 2, 0},
+                              BOX_SIZE, BOX_SIZE, 1);
+  body_set_continuous(*box, true);
+  body_set_velocity(*box, (vector_t){speed, 0});
+  scene_add_body(scene, *wall);
+  scene_add_body(scene, *box);
+  return scene;
+}
+
+static double box_front(body_t *box) {
+  return body_get_centroid(box).x + BOX_SIZE / 2;
+}
+
+/**
+ * Moves the box through the wall, and checks the time of impact and the
+ * contact point.
+ *
+ * @return whether both are where they should be
+ */
+static bool check_time_of_impact(double speed, double gap) {
+  body_t *box;
+  body_t *wall;
+  scene_t *scene = make_scene(speed, gap, &box, &wall);
+  scene_tick(scene, DT);
+  double expected = gap / (speed * DT);
+  collision_info_t info = find_collision(box, wall);
+  bool correct = info.collided && fabs(info.time - expected) < MAX_ERROR;
+  printf("  speed %6.0f gap %4.0f: time %.6f (expected %.6f)", speed, gap,
+         info.collided ? info.time : NAN, expected);
+  if (info.collided) {
+    collision_move_to_contact(box, wall, info);
+    printf(", front at %.6f", box_front(box));
+    correct = correct && fabs(box_front(box) - WALL_X) < MAX_ERROR;
+  }
+  printf("%s\n", correct ? "" : "  WRONG");
+  scene_free(scene);
+  return correct;
+}
+
+/**
+ * Bounces the box off the wall with a physics collision.
+ *
+ * @return whether it bounced back from the near side of the wall
+ */
+static bool check_bounce(double speed, double gap) {
+  body_t *box;
+  body_t *wall;
+  scene_t *scene = make_scene(speed, gap, &box, &wall);
+  create_physics_collision(scene, box, wall, 1);
+  // the collision is found at the start of the second tick
+  scene_tick(scene, DT);
+  scene_tick(scene, DT);
+  bool correct = box_front(box) <= WALL_X + MAX_ERROR &&
+                 body_get_velocity(box).x == -speed;
+  printf("  speed %6.0f gap %4.0f: front at %.6f, velocity %.0f%s\n", speed,
+         gap, box_front(box), body_get_velocity(box).x,
+         correct ? "" : "  WRONG");
+  scene_free(scene);
+  return correct;
+}
+
+/**
+ * Times find_collision() on a box that was swept through the wall.
+ *
+ * @return the number of nanoseconds per test
+ */
+static double time_swept_tests(size_t iterations) {
+  body_t *box;
+  body_t *wall;
+  scene_t *scene = make_scene(SPEEDS[0], GAPS[0], &box, &wall);
+  scene_tick(scene, DT);
+  volatile size_t collisions = 0;
+  double start = bench_now();
+  for (size_t i = 0; i < iterations; i++) {
+    collisions += find_collision(box, wall).collided;
+  }
+  double elapsed = bench_now() - start;
+  scene_free(scene);
+  return elapsed / iterations * 1e9;
+}
+
+int main(int argc, char **argv) {
+  size_t iterations = bench_arg(argc, argv, 1, DEFAULT_ITERATIONS);
+  bool correct = true;
+
+  printf("time of impact with a %g wide wall at x = %g:\n", WALL_WIDTH,
+         WALL_X);
+  for (size_t s = 0; s < NUM_SPEEDS; s++) {
+    for (size_t g = 0; g < NUM_GAPS; g++) {
+      correct = check_time_of_impact(SPEEDS[s], GAPS[g]) && correct;
+    }
+  }
+  printf("elastic bounce off the wall:\n");
+  for (size_t s = 0; s < NUM_SPEEDS; s++) {
+    for (size_t g = 0; g < NUM_GAPS; g++) {
+      correct = check_bounce(SPEEDS[s], GAPS[g]) && correct;
+    }
+  }
+  printf("swept test: %.1f ns\n", time_swept_tests(iterations));
+
+  if (!correct) {
+    printf("a swept collision was resolved in the wrong place\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_util.h"
+#include "forces.h"
+#include "scene.h"
+#include "thread_pool.h"
+
+/**
+ * Times scene_tick() with a thread pool of 1 up to N workers, and checks
+ * that every body ends up exactly where it does in a scene without a pool.
+ * Every body has drag, two springs and gravity towards another body, which
+ * run as parallel force jobs, and some pairs of bodies have physics
+ * collisions, which run serially in between. There are enough bodies for
+ * integration to be split between the workers too.
+ * N defaults to the number of online processors, and is at least 4 so the
+ * parallel paths are exercised even on a single core.
+ *
+ * Usage: bench_thread_pool [max workers] [bodies] [ticks]
+ */
+
+const size_t MIN_MAX_WORKERS = 4;
+const size_t DEFAULT_BODIES = 50000;
+const size_t DEFAULT_TICKS = 20;
+const unsigned int SEED = 7;
+// bodies are placed at random in [0, WORLD_SIZE) on both axes
+const int WORLD_SIZE = 1000;
+// every COLLISION_SPACING-th body collides with the next one
+const size_t COLLISION_SPACING = 100;
+const double DT = 0.01;
+const double DRAG = 0.1;
+const double NEIGHBOR_SPRING = 0.5;
+const double ANCHOR_SPRING = 0.01;
+// bodies are also pulled towards one of the first ANCHORS bodies
+const size_t ANCHORS = 7;
+const double G = 100;
+const double ELASTICITY = 0.5;
+
+/**
+ * Makes the same scene every time it is called.
+ */
+static scene_t *make_scene(size_t num_bodies) {
+  scene_t *scene = scene_init();
+  srand(SEED);
+  for (size_t i = 0; i < num_bodies; i++) {
+    vector_t center = {rand() % WORLD_SIZE, rand() % WORLD_SIZE};
+    scene_add_body(scene, bench_make_rectangle(center, 2, 2, 1 + i % 5));
+  }
+  for (size_t i = 0; i < num_bodies; i++) {
+    body_t *body = scene_get_body(scene, i);
+    create_drag(scene, DRAG, body);
+    create_spring(scene, NEIGHBOR_SPRING, body,
+                  scene_get_body(scene, (i + 1) % num_bodies));
+    create_spring(scene, ANCHOR_SPRING, body,
+                  scene_get_body(scene, i % ANCHORS));
+    create_newtonian_gravity(scene, G, body,
+                             scene_get_body(scene, (i * 31 + 5) % num_bodies));
+    if (i % COLLISION_SPACING == 0) {
+      create_physics_collision(scene, body,
+                               scene_get_body(scene, (i + 1) % num_bodies),
+                               ELASTICITY);
+    }
+  }
+  return scene;
+}
+
+/**
+ * Ticks a scene.
+ *
+ * @return the number of seconds per tick
+ */
+static double run_ticks(scene_t *scene, size_t num_ticks) {
+  double start = bench_now();
+  for (size_t i = 0; i < num_ticks; i++) {
+    scene_tick(scene, DT);
+  }
+  return (bench_now() - start) / num_ticks;
+}
+
+/**
+ * Counts the bodies whose position or velocity is not bit for bit the same
+ * in two scenes made by make_scene().
+ */
+static size_t count_mismatches(scene_t *scene, scene_t *reference) {
+  size_t mismatches = 0;
+  for (size_t i = 0; i < scene_bodies(scene); i++) {
+    body_t *body = scene_get_body(scene, i);
+    body_t *expected = scene_get_body(reference, i);
+    vector_t centers[] = {body_get_centroid(body),
+                          body_get_centroid(expected)};
+    vector_t velocities[] = {body_get_velocity(body),
+                             body_get_velocity(expected)};
+    if (memcmp(&centers[0], &centers[1], sizeof(vector_t)) != 0 ||
+        memcmp(&velocities[0], &velocities[1], sizeof(vector_t)) != 0) {
+      mismatches++;
+    }
+  }
+  return mismatches;
+}
+
+int main(int argc, char **argv) {
+  long processors = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t default_workers = processors > (long)MIN_MAX_WORKERS
+                               ? (size_t)processors
+                               : MIN_MAX_WORKERS;
+  size_t max_workers = bench_arg(argc, argv, 1, default_workers);
+  size_t num_bodies = bench_arg(argc, argv, 2, DEFAULT_BODIES);
+  size_t num_ticks = bench_arg(argc, argv, 3, DEFAULT_TICKS);
+
+  scene_t *reference = make_scene(num_bodies);
+  double serial = run_ticks(reference, num_ticks);
+  printf("%zu bodies, %ld processors\n", num_bodies, processors);
+  printf("no pool:    %8.2f ms/tick\n", serial * 1e3);
+
+  size_t total_mismatches = 0;
+  for (size_t workers = 1; workers <= max_workers; workers++) {
+    scene_t *scene = make_scene(num_bodies);
+    thread_pool_t *pool = thread_pool_init(workers);
+    scene_set_thread_pool(scene, pool);
+    double parallel = run_ticks(scene, num_ticks);
+    size_t mismatches = count_mismatches(scene, reference);
+    printf("%2zu workers: %8.2f ms/tick  speedup %5.2fx  mismatches %zu\n",
+           workers, parallel * 1e3, serial / parallel, mismatches);
+    total_mismatches += mismatches;
+    scene_free(scene);
+    thread_pool_free(pool);
+  }
+  scene_free(reference);
+  return total_mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
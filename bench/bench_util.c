@@ -0,0 +1,31 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bench_util.h"
+
+const rgb_color_t BENCH_COLOR = {0, 0, 0};
+
+double bench_now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+size_t bench_arg(int argc, char **argv, int index, size_t fallback) {
+  if (index >= argc) {
+    return fallback;
+  }
+  long value = strtol(argv[index], NULL, 10);
+  assert(value > 0);
+  return value;
+}
+
+body_t *bench_make_rectangle(vector_t center, double width, double height,
+                             double mass) {
+  vector_t shape[] = {{center.x - width / 2, center.y - height / 2},
+                      {center.x + width / 2, center.y - height / 2},
+                      {center.x + width / 2, center.y + height / 2},
+                      {center.x - width / 2, center.y + height / 2}};
+  return body_init(shape, sizeof(shape) / sizeof(*shape), mass, BENCH_COLOR);
+}
@@ -0,0 +1,44 @@
+#ifndef __BENCH_UTIL_H__
+#define __BENCH_UTIL_H__
+
+#include <stddef.h>
+
+#include "body.h"
+
+/**
+ * Helpers shared by the benchmarks in bench/.
+ * Build and run them with 'make NO_ASAN=true bench'; timings taken with
+ * asan enabled mostly measure asan.
+ */
+
+/**
+ * Gets the current time from a monotonic clock.
+ *
+ * @return the time in seconds since an arbitrary starting point
+ */
+double bench_now(void);
+
+/**
+ * Reads an optional positive integer argument, e.g. an iteration count.
+ *
+ * @param argc the number of command line arguments
+ * @param argv the command line arguments
+ * @param index the index of the argument to read
+ * @param fallback the value to return if the argument is missing
+ * @return the argument's value, or fallback
+ */
+size_t bench_arg(int argc, char **argv, int index, size_t fallback);
+
+/**
+ * Allocates a rectangular body.
+ *
+ * @param center the centroid of the rectangle
+ * @param width the width of the rectangle
+ * @param height the height of the rectangle
+ * @param mass the mass of the body
+ * @return a pointer to the newly allocated body
+ */
+body_t *bench_make_rectangle(vector_t center, double width, double height,
+                             double mass);
+
+#endif // #ifndef __BENCH_UTIL_H__
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include "arena.h"
 #include "asset_cache.h"
 #include "collision.h"
 #include "forces.h"
@@ -20,6 +21,26 @@ const vector_t CHARACTER1_POS = {70, 50};
 const vector_t CHARACTER2_POS = {850, 50};
 const vector_t LEVEL_TWO_CHARACTER2_POS = {850, 250};
 
+// level four blows a breeze towards the player that gusts every few seconds,
+// with an updraft over the middle of the field
+const vector_t LEVEL_FOUR_WIND_SAMPLES[] = {
+  // calm
+  {-20, 0}, {-20, 10}, {-20, 0},
+  {-30, 0}, {-30, 15}, {-30, 0},
+  // gust
+  {-60, 0}, {-60, 30}, {-60, 0},
+  {-90, 0}, {-90, 45}, {-90, 0},
+};
+const vector_field_t LEVEL_FOUR_WIND = {
+  .origin = {0, 0},
+  .spacing = 500,
+  .columns = 3,
+  .rows = 2,
+  .num_frames = 2,
+  .frame_duration = 3,
+  .samples = LEVEL_FOUR_WIND_SAMPLES,
+};
+
 const level_info_t levels_info[] = {
   { .screen_name = LEVEL_ONE,
     .background_image_path = "assets/level_one_background.png",
@@ -71,7 +92,8 @@ const level_info_t levels_info[] = {
     .use_ai = true,
     .ai_difficulty = 75,
     .character_2_velocity = (vector_t){0, 100},
-    .level_gravity = (vector_t){0, -100}},
+    .level_gravity = (vector_t){0, -100},
+    .wind = &LEVEL_FOUR_WIND},
 
   { .screen_name = LEVEL_FIVE,
     .background_image_path = "assets/level_five_background.png",
@@ -109,6 +131,7 @@ state_t *emscripten_init() {
 }
 
 bool emscripten_main(state_t *state) {
+  frame_arena_reset();
   sdl_clear();
   state_current_main(state);
   sdl_show();
@@ -0,0 +1,156 @@
+#ifndef __ALLOC_H__
+#define __ALLOC_H__
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Accounts for the heap allocations made by the library.
+ * Every file in library/ that allocates defines ALLOC_TAG as the subsystem
+ * it belongs to and then includes this header after the standard headers,
+ * which routes its malloc(), calloc() and realloc() calls through the
+ * versions below. Files that never allocate, e.g. vector.c and collision.c,
+ * include neither.
+ * The number of allocations and bytes requested is always counted per
+ * subsystem; sdl_get_frame_stats() reports the total per frame, which should
+ * be close to zero once a level is running.
+ *
+ * Building with ALLOC_TRACKING defined (make ALLOC_TRACKING=true) also
+ * routes free() here and records every live allocation with the file and
+ * line that made it. alloc_report() is then printed to stderr on exit, so a
+ * leak shows up as the call site that keeps allocating.
+ */
+
+/**
+ * The subsystems allocations are charged to.
+ */
+typedef enum {
+  /** Bodies, polygons, forces and the scene */
+  ALLOC_TAG_PHYSICS,
+  /** The renderer and colors */
+  ALLOC_TAG_RENDER,
+  /** Assets and the asset cache */
+  ALLOC_TAG_ASSETS,
+  /** Levels, characters and the game state */
+  ALLOC_TAG_LEVEL,
+  /** Lists, arenas, pools and the thread pool, shared by the others */
+  ALLOC_TAG_CORE,
+  NUM_ALLOC_TAGS
+} alloc_tag_t;
+
+/**
+ * The allocations charged to a subsystem.
+ */
+typedef struct {
+  /** The number of calls to malloc(), calloc() and realloc() */
+  size_t allocations;
+  /** The number of bytes those calls requested */
+  size_t bytes;
+  /** The number of allocations not yet freed; only with ALLOC_TRACKING */
+  size_t live_allocations;
+  /** The number of bytes not yet freed; only with ALLOC_TRACKING */
+  size_t live_bytes;
+} alloc_stats_t;
+
+/**
+ * Calls malloc() and charges the allocation to a subsystem.
+ *
+ * @param size the number of bytes to allocate
+ * @param tag the subsystem making the allocation
+ * @param site the file and line making the allocation
+ * @return the memory, or NULL if it could not be allocated
+ */
+void *alloc_malloc(size_t size, alloc_tag_t tag, const char *site);
+
+/**
+ * Calls calloc() and charges the allocation to a subsystem.
+ *
+ * @param count the number of elements to allocate
+ * @param size the size of each element
+ * @param tag the subsystem making the allocation
+ * @param site the file and line making the allocation
+ * @return the zeroed memory, or NULL if it could not be allocated
+ */
+void *alloc_calloc(size_t count, size_t size, alloc_tag_t tag,
+                   const char *site);
+
+/**
+ * Calls realloc() and charges the allocation to a subsystem.
+ *
+ * @param pointer the memory to resize, or NULL
+ * @param size the new number of bytes
+ * @param tag the subsystem making the allocation
+ * @param site the file and line making the allocation
+ * @return the resized memory, or NULL if it could not be allocated
+ */
+void *alloc_realloc(void *pointer, size_t size, alloc_tag_t tag,
+                    const char *site);
+
+/**
+ * Frees memory allocated with alloc_malloc(), alloc_calloc() or
+ * alloc_realloc(). Only library code built with ALLOC_TRACKING calls this in
+ * place of free().
+ *
+ * @param pointer the memory to free, or NULL
+ */
+void alloc_free(void *pointer);
+
+/**
+ * Gets the number of allocations made by the library since it started.
+ *
+ * @return the number of calls to malloc(), calloc() and realloc()
+ */
+size_t alloc_get_count(void);
+
+/**
+ * Gets the allocations charged to a subsystem since the library started.
+ *
+ * @param tag the subsystem
+ * @return its allocation counts
+ */
+alloc_stats_t alloc_get_stats(alloc_tag_t tag);
+
+/**
+ * Gets the name of a subsystem, as printed by alloc_report().
+ *
+ * @param tag the subsystem
+ * @return its name, e.g. "physics"
+ */
+const char *alloc_tag_name(alloc_tag_t tag);
+
+/**
+ * Records the allocations each subsystem made since the last call as one
+ * frame's churn. Called once per frame, by sdl_clear().
+ */
+void alloc_end_frame(void);
+
+/**
+ * Prints the allocations of each subsystem, their average and largest
+ * churn per frame, and, with ALLOC_TRACKING, the live allocations grouped by
+ * call site, largest first.
+ *
+ * @param out the stream to print to
+ */
+void alloc_report(FILE *out);
+
+#ifndef ALLOC_NO_REDIRECT
+#ifndef ALLOC_TAG
+#error "define ALLOC_TAG as the file's subsystem before including alloc.h"
+#endif
+
+#define ALLOC_STRINGIFY_VALUE(value) #value
+#define ALLOC_STRINGIFY(value) ALLOC_STRINGIFY_VALUE(value)
+#define ALLOC_SITE __FILE__ ":" ALLOC_STRINGIFY(__LINE__)
+
+#define malloc(size) alloc_malloc(size, ALLOC_TAG, ALLOC_SITE)
+#define calloc(count, size) alloc_calloc(count, size, ALLOC_TAG, ALLOC_SITE)
+#define realloc(pointer, size)                                                 \
+  alloc_realloc(pointer, size, ALLOC_TAG, ALLOC_SITE)
+// not function-like, so passing free as a list's freer is redirected too
+#ifdef ALLOC_TRACKING
+#define free alloc_free
+#endif
+#endif
+
+#endif // #ifndef __ALLOC_H__
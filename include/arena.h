@@ -0,0 +1,67 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+
+/**
+ * A bump-pointer allocator for short-lived memory.
+ * Allocating just advances a pointer, and everything allocated is released
+ * at once by arena_reset(); there is no way to free a single allocation.
+ * When an arena runs out of room it chains another block, and the next
+ * reset merges the blocks into one, so an arena that is reset regularly
+ * soon stops calling malloc().
+ */
+typedef struct arena arena_t;
+
+/**
+ * Allocates an empty arena.
+ * Asserts that the required memory is successfully allocated.
+ *
+ * @param capacity the number of bytes to reserve up front
+ * @return the new arena
+ */
+arena_t *arena_init(size_t capacity);
+
+/**
+ * Releases the memory of an arena and everything allocated from it.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ */
+void arena_free(arena_t *arena);
+
+/**
+ * Allocates memory from an arena, aligned for any type.
+ * The memory is valid until the arena is reset or freed.
+ * Asserts that the required memory is successfully allocated.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ * @param size the number of bytes to allocate
+ * @return a pointer to the memory
+ */
+void *arena_alloc(arena_t *arena, size_t size);
+
+/**
+ * Releases everything allocated from an arena, keeping its memory for reuse.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ */
+void arena_reset(arena_t *arena);
+
+/**
+ * Allocates memory that lasts until the end of the current frame, from an
+ * arena shared by the library. Meant for scratch space whose size is not
+ * known at compile time; fixed-size scratch belongs on the stack.
+ * Must only be called from the main thread.
+ *
+ * @param size the number of bytes to allocate
+ * @return a pointer to the memory
+ */
+void *frame_alloc(size_t size);
+
+/**
+ * Releases everything allocated with frame_alloc().
+ * Called once at the start of every frame.
+ */
+void frame_arena_reset(void);
+
+#endif // #ifndef __ARENA_H__
@@ -11,6 +11,17 @@
 
 typedef enum { ASSET_IMAGE, ASSET_FONT, ASSET_BUTTON, ASSET_BODY} asset_type_t;
 
+/**
+ * The z-layers assets are drawn in, from back to front.
+ * Assets default to LAYER_WORLD.
+ */
+typedef enum {
+  LAYER_BACKGROUND,
+  LAYER_WORLD,
+  LAYER_HUD,
+  LAYER_OVERLAY
+} asset_layer_t;
+
 typedef struct asset asset_t;
 
 /**
@@ -85,8 +96,8 @@ typedef void (*button_handler_t)(void *state);
 
 /**
  * Allocates memory for a button asset with the given parameters.
- * Note that `image_asset` and `text_asset` should be owned by the caller. Thus,
- * `asset_destroy` will only free the memory allocated for the button.
+ * The button takes ownership of `image_asset` and `text_asset`, so
+ * `asset_destroy` frees them along with the button.
  *
  * Asserts that `image_asset` is NULL or has type `ASSET_IMAGE`.
  * Asserts that `text_asset` is NULL or has type `ASSET_FONT`.
@@ -123,7 +134,26 @@ void asset_on_button_click(asset_t *button, state_t *state, double x, double y);
 void asset_set_image(asset_t *asset, const char *filepath);
 
 /**
- * Renders the asset to the screen.
+ * Sets the z-layer the asset is drawn in. For buttons, also sets the layer of
+ * the button's image and text.
+ *
+ * @param asset pointer to the asset
+ * @param layer the layer to draw the asset in
+ */
+void asset_set_layer(asset_t *asset, asset_layer_t layer);
+
+/**
+ * Sets how far between the last two physics states assets attached to
+ * bodies are drawn. See body_get_interpolation_offset().
+ *
+ * @param alpha from 0 (the previous state) to 1 (the current state, which
+ *   is the default)
+ */
+void asset_set_interpolation(double alpha);
+
+/**
+ * Queues the asset to be drawn on the screen. Nothing is drawn until the
+ * frame is shown with sdl_show().
  * @param asset the asset to render
  */
 void asset_render(asset_t *asset);
@@ -2,6 +2,7 @@
 #define __BODY_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "color.h"
 #include "list.h"
@@ -9,23 +10,75 @@
 
 /**
  * A rigid body constrained to the plane.
- * Implemented as a polygon with uniform density.
+ * Implemented as a polygon with uniform density. The body, its polygon and
+ * the polygon's vertices share one allocation.
  */
 typedef struct body body_t;
 
+/**
+ * A bitmask of the collision categories a body belongs to.
+ * The scene only tests bodies for collisions by category, so a body with
+ * category 0 (the default) never collides.
+ */
+typedef uint32_t body_category_t;
+
+/**
+ * How the scene moves a body each tick.
+ */
+typedef enum {
+  /** Moved by the forces and impulses applied to it (the default) */
+  BODY_DYNAMIC,
+  /** Moved at its own velocity, ignoring forces and impulses */
+  BODY_KINEMATIC,
+  /** Never moved by the scene, and never tested against other static bodies */
+  BODY_STATIC,
+} body_type_t;
+
+// A force job acting on a body; see forces.h
+struct force_job;
+
+/**
+ * Recycled memory for bodies, so that creating and freeing bodies does not
+ * call malloc() or free() once the pool has grown to its working size.
+ * Each scene owns one; see scene_get_body_pool().
+ */
+typedef struct body_pool body_pool_t;
+
+/**
+ * A force or impulse on a body, recorded while forces are deferred.
+ */
+typedef struct {
+  body_t *body;
+  vector_t value;
+  bool is_impulse;
+} body_force_t;
+
+/**
+ * A growable array of deferred forces and impulses, in the order they were
+ * added. See body_defer_forces().
+ */
+typedef struct {
+  body_force_t *forces;
+  size_t size;
+  size_t capacity;
+} body_force_buffer_t;
+
 /**
  * Initializes a body without any info.
  * Acts like body_init_with_info() where info and info_freer are NULL.
  */
 
-body_t *body_init(list_t *shape, double mass, rgb_color_t color);
+body_t *body_init(const vector_t *shape, size_t num_points, double mass,
+                  rgb_color_t color);
 
 /**
  * Allocates memory for a body with the given parameters.
  * The body is initially at rest.
  * Asserts that the mass is positive and that the required memory is allocated.
  *
- * @param shape a list of vectors describing the initial shape of the body
+ * @param shape an array of vectors describing the initial shape of the body.
+ *   The vertices are copied, so the array may be on the stack.
+ * @param num_points the number of vertices in shape
  * @param mass the mass of the body (if INFINITY, stops the body from moving)
  * @param color the color of the body, used to draw it on the screen
  * @param info additional information to associate with the body,
@@ -33,25 +86,101 @@ body_t *body_init(list_t *shape, double mass, rgb_color_t color);
  * @param info_freer if non-NULL, a function call on the info to free it
  * @return a pointer to the newly allocated body
  */
-body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
-                            void *info, free_func_t info_freer);
+body_t *body_init_with_info(const vector_t *shape, size_t num_points,
+                            double mass, rgb_color_t color, void *info,
+                            free_func_t info_freer);
+
+/**
+ * Initializes a body like body_init_with_info(), taking its memory from a
+ * pool instead of the system allocator. body_free() returns the memory to
+ * the pool.
+ *
+ * @param pool a pointer to a pool returned from body_pool_init()
+ * @param shape an array of vectors describing the initial shape of the body
+ * @param num_points the number of vertices in shape
+ * @param mass the mass of the body (if INFINITY, stops the body from moving)
+ * @param color the color of the body, used to draw it on the screen
+ * @param info additional information to associate with the body
+ * @param info_freer if non-NULL, a function call on the info to free it
+ * @return a pointer to the new body
+ */
+body_t *body_init_in_pool(body_pool_t *pool, const vector_t *shape,
+                          size_t num_points, double mass, rgb_color_t color,
+                          void *info, free_func_t info_freer);
 
 /**
  * Releases the memory allocated for a body.
+ * A body from a pool goes back to that pool.
  *
  * @param body a pointer to a body returned from body_init()
  */
 void body_free(body_t *body);
 
+/**
+ * Allocates an empty body pool.
+ * Asserts that the required memory is successfully allocated.
+ *
+ * @return the new pool
+ */
+body_pool_t *body_pool_init(void);
+
+/**
+ * Releases the memory of a body pool and of every body allocated from it,
+ * in time proportional to the number of chunks the pool allocated rather
+ * than the number of bodies. Bodies that were not passed to body_free()
+ * first must not be used afterwards, and their info is not freed.
+ *
+ * @param pool a pointer to a pool returned from body_pool_init()
+ */
+void body_pool_free(body_pool_t *pool);
+
 /**
  * Gets the current shape of a body.
  * Returns a newly allocated vector list, which must be list_free()d.
+ * Only use this when the caller needs to own the vertices; to read them,
+ * use body_get_shape_view(), which does not allocate.
  *
  * @param body a pointer to a body returned from body_init()
  * @return the polygon describing the body's current position
  */
 list_t *body_get_shape(body_t *body);
 
+/**
+ * Gets a read-only view of a body's current vertices without copying them.
+ * The view is invalidated when the body is moved, reshaped or freed.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return a view of the body's vertices
+ */
+shape_view_t body_get_shape_view(body_t *body);
+
+/**
+ * Gets the number of vertices in a body's shape.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the number of vertices
+ */
+size_t body_num_vertices(body_t *body);
+
+/**
+ * Reads one vertex of a body's current shape without copying the shape.
+ * Asserts that the index is valid.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param index the index of the vertex, in counterclockwise order
+ * @return the vertex at that index
+ */
+vector_t body_get_vertex(body_t *body, size_t index);
+
+/**
+ * Gets the unit normals of a body's edges, e.g. for use as separating axes.
+ * See polygon_get_normals().
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return an array of body_num_vertices() unit normals
+ */
+const vector_t *body_get_normals(body_t *body);
+
 /**
  * Gets the current center of mass of a body.
  * While this could be calculated with polygon_centroid(), that becomes too slow
@@ -63,6 +192,24 @@ list_t *body_get_shape(body_t *body);
  */
 vector_t body_get_centroid(body_t *body);
 
+/**
+ * Gets the axis-aligned bounding box of a body.
+ * The box is cached by the body's polygon, so this is usually O(1).
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's bounding box
+ */
+aabb_t body_get_aabb(body_t *body);
+
+/**
+ * Gets the axis-aligned bounding box the body would have if it were not
+ * rotated, at its current position.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's unrotated bounding box
+ */
+aabb_t body_get_unrotated_aabb(body_t *body);
+
 /**
  * Gets the current velocity of a body.
  *
@@ -121,6 +268,7 @@ void body_set_color(body_t *body, rgb_color_t *col);
 /**
  * Translates a body to a new position.
  * The position is specified by the position of the body's center of mass.
+ * The move is instantaneous, so it resets body_get_last_displacement().
  *
  * @param body a pointer to a body returned from body_init()
  * @param x the body's new centroid
@@ -143,6 +291,42 @@ void body_set_velocity(body_t *body, vector_t v);
  */
 void body_set_rotate_with_velocity(body_t *body, bool rotate_with_velocity);
 
+/**
+ * Sets whether a body is fast enough to need continuous collision detection.
+ * find_collision() sweeps such bodies along their displacement over the last
+ * tick, so they cannot pass through a thin body between two ticks.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param continuous whether to sweep the body's motion for collisions
+ */
+void body_set_continuous(body_t *body, bool continuous);
+
+/**
+ * Returns whether a body uses continuous collision detection.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return whether the body was marked with body_set_continuous()
+ */
+bool body_is_continuous(body_t *body);
+
+/**
+ * Gets how far a body moved during its last body_tick().
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's displacement over the last tick
+ */
+vector_t body_get_last_displacement(body_t *body);
+
+/**
+ * Gets the bounding box of the area a body covered during its last tick.
+ * For continuous bodies this includes where the body started the tick;
+ * for other bodies it is the same as body_get_aabb().
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's swept bounding box
+ */
+aabb_t body_get_swept_aabb(body_t *body);
+
 /**
  * Changes a body's orientation in the plane.
  * The body is rotated about its center of mass.
@@ -156,11 +340,15 @@ void body_set_rotation(body_t *body, double angle);
 /**
  * Sets polygon of the body with everything the same except the shape changed
  * Frees the polygon that is replaced
+ * The new polygon reuses the body's memory if it has no more vertices than
+ * the body was created with, so shape must not point into the body's own
+ * vertices, e.g. from body_get_shape_view().
  *
  * @param body a pointer to a body returned from body_init()
- * @param shape a list representing the shape of the new polygon
+ * @param shape an array of vectors representing the shape of the new polygon
+ * @param num_points the number of vertices in shape
  */
-void body_set_shape(body_t *body, list_t *shape);
+void body_set_shape(body_t *body, const vector_t *shape, size_t num_points);
 
 /**
  * Updates the body after a given time interval has elapsed.
@@ -175,6 +363,65 @@ void body_set_shape(body_t *body, list_t *shape);
  */
 void body_tick(body_t *body, double dt);
 
+/**
+ * Finishes a tick whose new velocity and displacement were computed outside
+ * the body, e.g. by integrator_step() for many bodies at once.
+ * Translates the body, sets its velocity, and resets the forces and impulses
+ * accumulated on it, exactly as body_tick() does.
+ *
+ * @param body the body to advance
+ * @param new_velocity the velocity of the body at the end of the tick
+ * @param displacement how far the body moves during the tick
+ */
+void body_advance(body_t *body, vector_t new_velocity, vector_t displacement);
+
+/**
+ * Moves a body back along its last displacement, as if its last tick had
+ * only carried it part of the way. Its velocity is unchanged.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param fraction how much of its last displacement the body keeps, in [0, 1]
+ */
+void body_rewind(body_t *body, double fraction);
+
+/**
+ * Gets how far a body is from where it would be drawn when interpolating
+ * between its positions before and after its last tick.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param alpha how far through the next tick the drawn frame is, from 0
+ *   (the position before the last tick) to 1 (the current position)
+ * @return the offset to add to the body's current position
+ */
+vector_t body_get_interpolation_offset(body_t *body, double alpha);
+
+/**
+ * Gets the acceleration of a body during its last tick, i.e. the force then
+ * accumulated on it over its mass. If the body's velocity has been set since
+ * (or it has never been ticked), gets the acceleration from the force
+ * accumulated so far during the current tick instead.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's last acceleration
+ */
+vector_t body_get_last_acceleration(body_t *body);
+
+/**
+ * Gets the force accumulated on a body during the current tick.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the sum of the forces added with body_add_force()
+ */
+vector_t body_get_force(body_t *body);
+
+/**
+ * Gets the impulse accumulated on a body during the current tick.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the sum of the impulses added with body_add_impulse()
+ */
+vector_t body_get_impulse(body_t *body);
+
 /**
  * Applies a force to a body over the current tick.
  * If multiple forces are applied in the same tick, they should be added.
@@ -197,6 +444,17 @@ void body_add_force(body_t *body, vector_t force);
  */
 void body_add_impulse(body_t *body, vector_t impulse);
 
+/**
+ * Makes body_add_force() and body_add_impulse() on the calling thread append
+ * to a buffer instead of changing the body, so force creators can run on
+ * several threads at once. The caller applies the buffered forces later.
+ * Only affects the calling thread.
+ *
+ * @param buffer the buffer to append to, or NULL to apply forces directly
+ *   again
+ */
+void body_defer_forces(body_force_buffer_t *buffer);
+
 /**
  * Clear the forces and impulses on the body.
  *
@@ -223,4 +481,75 @@ void body_remove(body_t *body);
  */
 bool body_is_removed(body_t *body);
 
+/**
+ * Sets the collision categories a body belongs to.
+ * See scene_add_category_collision().
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param category a bitmask of the body's categories
+ */
+void body_set_category(body_t *body, body_category_t category);
+
+/**
+ * Gets the collision categories a body belongs to.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return a bitmask of the body's categories
+ */
+body_category_t body_get_category(body_t *body);
+
+/**
+ * Sets how the scene moves a body. Static and kinematic bodies can still
+ * be moved directly, e.g. with body_set_centroid() or body_set_velocity().
+ * Discards the forces and impulses accumulated on the body.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param type the body's type
+ */
+void body_set_type(body_t *body, body_type_t type);
+
+/**
+ * Gets how the scene moves a body.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the type set with body_set_type(), or BODY_DYNAMIC
+ */
+body_type_t body_get_type(body_t *body);
+
+/**
+ * Records that a force job acts on a body, so that the scene can find the
+ * job without scanning every force job when the body is removed.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param job the force job acting on the body
+ */
+void body_add_force_job(body_t *body, struct force_job *job);
+
+/**
+ * Forgets every force job recorded on a body that matches a predicate,
+ * in a single pass.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param should_remove the predicate for force jobs to forget
+ */
+void body_remove_force_jobs_if(body_t *body, list_pred_t should_remove);
+
+/**
+ * Gets the number of force jobs recorded as acting on a body.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the number of force jobs
+ */
+size_t body_num_force_jobs(body_t *body);
+
+/**
+ * Gets a force job recorded as acting on a body.
+ * Asserts that the index is valid.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param index the index of the force job (starting at 0)
+ * @return the force job at that index
+ */
+struct force_job *body_get_force_job(body_t *body, size_t index);
+
 #endif // #ifndef __BODY_H__
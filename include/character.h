@@ -4,6 +4,7 @@
 #include "body.h"
 #include "list.h"
 #include "vector.h"
+#include "vector_field.h"
 #include "asset.h"
 #include <stdbool.h>
 
@@ -118,7 +119,8 @@ void character_deduct_health(character_t *character, double damage);
 
 /**
  * Updates the green part of the health bar based on the fraction of the current
- * health to the max health
+ * health to the max health. Does nothing if the health has not changed since
+ * the last update.
  * 
  * @param character pointer to a character
 */
@@ -146,9 +148,11 @@ vector_t character_shot_velocity(vector_t shot_start_point, vector_t shot_end_po
  * @param target where the shot needs to hit
  * @param difficulty scale from 0 to 100 of how accurate the ai is, 100 being absolutely accurate
  * @param gravity which is used as a force on the shot
+ * @param wind the level's wind, which also pushes the shot, or NULL for none
+ * @param wind_time the time the wind is sampled at when the shot is fired
  * @return the inital velocity of the shot
  */
-vector_t character_ai_shot_velocity(vector_t shot_origin, vector_t target, double difficulty, vector_t gravity);
+vector_t character_ai_shot_velocity(vector_t shot_origin, vector_t target, double difficulty, vector_t gravity, const vector_field_t *wind, double wind_time);
 
 /**
  * Sets the character velocity.
@@ -20,16 +20,83 @@ typedef struct {
    * If collided is false, this value is undefined.
    */
   vector_t axis;
+  /**
+   * If the shapes are colliding, how far through their last tick they first
+   * touched, from 0 to 1. This is 1 if they overlap where they are now, and
+   * less only if a continuous body was swept into the other one.
+   * If collided is false, this value is undefined.
+   */
+  double time;
 } collision_info_t;
 
+/**
+ * Counts of the collision tests run by each path of find_collision().
+ */
+typedef struct {
+  /** Tests between two axis-aligned rectangles */
+  size_t aabb_tests;
+  /** Tests between two rectangles, at least one of them rotated */
+  size_t box_tests;
+  /** Tests that used the general separating axis test */
+  size_t convex_tests;
+  /** Tests that also swept a continuous body along its last displacement */
+  size_t swept_tests;
+} collision_stats_t;
+
+/**
+ * A function called when a collision occurs.
+ * For collisions with a scene's world bounds, body2 is NULL.
+ * @param body1 the first body passed to create_collision(),
+ *   or the body in the first category of a category collision
+ * @param body2 the second body passed to create_collision(),
+ *   or the body in the second category of a category collision
+ * @param axis a unit vector pointing from body1 towards body2
+ *   that defines the direction the two bodies are colliding in
+ * @param aux the auxiliary value passed when registering the collision
+ * @param force_const the force constant passed when registering the collision
+ */
+typedef void (*collision_handler_t)(body_t *body1, body_t *body2, vector_t axis,
+                                    void *aux, double force_const);
+
 /**
  * Computes the status of the collision between two bodies.
+ * If the bodies are apart but either of them is continuous (see
+ * body_set_continuous()), also checks whether they touched at any point
+ * during their last tick, so that fast bodies cannot pass through others.
  *
  * @param body1 the first body
  * @param body2 the second body
- * @return whether the shapes are colliding, and if so, the collision axis.
+ * @return whether the shapes are colliding, and if so, the collision axis
+ * and the time they first touched.
  * The axis should be a unit vector pointing from shape1 towards shape2.
  */
 collision_info_t find_collision(body_t *body1, body_t *body2);
 
+/**
+ * Moves two colliding bodies back to where they were when they first
+ * touched during their last tick, so that a fast body that was swept into
+ * the other one is resolved against its surface rather than past it.
+ * Bodies that overlap where they are now are left alone.
+ *
+ * @param body1 the first body passed to find_collision()
+ * @param body2 the second body passed to find_collision()
+ * @param info the collision find_collision() returned for the bodies
+ */
+void collision_move_to_contact(body_t *body1, body_t *body2,
+                               collision_info_t info);
+
+/**
+ * Returns how many tests each path of find_collision() has run since the
+ * last call to collision_reset_stats(). Rectangles take the specialized
+ * paths, so these show how much of a scene's collision work is generic.
+ *
+ * @return the collision test counts
+ */
+collision_stats_t collision_get_stats(void);
+
+/**
+ * Resets the counts returned by collision_get_stats().
+ */
+void collision_reset_stats(void);
+
 #endif // #ifndef __COLLISION_H__
@@ -4,18 +4,6 @@
 #include "collision.h"
 #include "scene.h"
 
-/**
- * A function called when a collision occurs.
- * @param body1 the first body passed to create_collision()
- * @param body2 the second body passed to create_collision()
- * @param axis a unit vector pointing from body1 towards body2
- *   that defines the direction the two bodies are colliding in
- * @param aux the auxiliary value passed to create_collision()
- * @param force_const the force constant passed to create_collision()
- */
-typedef void (*collision_handler_t)(body_t *body1, body_t *body2, vector_t axis,
-                                    void *aux, double force_const);
-
 /**
  * Adds a force creator to a scene that applies gravity between two bodies.
  * The force creator will be called each tick
@@ -117,18 +105,33 @@ void physics_collision_handler(body_t *body1, body_t *body2, vector_t axis,
 void create_physics_collision(scene_t *scene, body_t *body1, body_t *body2,
                               double elasticity);
 
+/**
+ * A force creator registered with a scene, together with the bodies it acts
+ * on. Up to FORCE_JOB_INLINE_BODIES bodies are stored in the job itself, so
+ * the force creators in this file cost a single allocation each.
+ */
 typedef struct force_job force_job_t;
 
+/**
+ * The most bodies a force job stores inline. Jobs with more bodies keep them
+ * in a separate allocation.
+ */
+enum { FORCE_JOB_INLINE_BODIES = 2 };
+
 /**
  * Allocates memory for a force job and sets the given force creator and its
  * required auxillory input.
  *
  * @param force_creator the function of type force_creator_t
- * @param aux pointer to auxillory input of type body_aux_t
+ * @param aux the auxiliary value to pass to force_creator
+ * @param bodies the bodies the job acts on.
+ *   They are copied into the job, so the list is still owned by the caller.
+ * @param aux_freer the function that frees aux when the job is freed,
+ *   or NULL if the job does not own aux
  * @return a pointer to a newly allocated force_job
  */
 force_job_t *forces_job_init(force_creator_t force_creator, void *aux,
-                             list_t *bodies);
+                             list_t *bodies, free_func_t aux_freer);
 
 /**
  * Runs the force job by calling the force creator with it's auxillory inputs.
@@ -138,20 +141,61 @@ force_job_t *forces_job_init(force_creator_t force_creator, void *aux,
 void forces_job_run(force_job_t *force_job);
 
 /**
- * Releases the memory allocated for a force job.
+ * Marks a force job as safe to run on any thread, concurrently with other
+ * such jobs. See scene_add_parallel_force_creator().
+ *
+ * @param force_job a pointer to a force job returned by forces_job_init()
+ * @param parallel whether the job may run in parallel
+ */
+void forces_job_set_parallel(force_job_t *force_job, bool parallel);
+
+/**
+ * Returns whether a force job may run in parallel with other jobs.
+ *
+ * @param force_job a pointer to a force job returned by forces_job_init()
+ * @return whether forces_job_set_parallel() marked the job as parallel
+ */
+bool forces_job_is_parallel(force_job_t *force_job);
+
+/**
+ * Marks a force job for removal. The scene stops running it and frees it at
+ * the end of the current tick.
+ *
+ * @param force_job a pointer to a force job returned by forces_job_init()
+ */
+void forces_job_remove(force_job_t *force_job);
+
+/**
+ * Returns whether a force job has been marked for removal.
+ *
+ * @param force_job a pointer to a force job returned by forces_job_init()
+ * @return whether forces_job_remove() has been called on the job
+ */
+bool forces_job_is_removed(force_job_t *force_job);
+
+/**
+ * Releases the memory allocated for a force job, and its auxiliary value if
+ * the job owns it.
  *
  * @param force_job a pointer to a force job returned by forces_job_init()
  */
 void forces_job_free(force_job_t *force_job);
 
 /**
- * Retrieves the list of bodies associated with a given force job.
+ * Gets the number of bodies a force job acts on.
+ *
+ * @param force_job a pointer to a force job returned by forces_job_init()
+ * @return the number of bodies
+ */
+size_t forces_job_num_bodies(force_job_t *force_job);
+
+/**
+ * Gets one of the bodies a force job acts on.
+ * Asserts that the index is valid.
  *
- * @param force_job A pointer to the force job from which to retrieve the
- * bodies.
- * @return A pointer to the list of bodies associated with the force job.
- *         Note: This function returns NULL if the force job or its auxiliary
- *         data is NULL.
+ * @param force_job a pointer to a force job returned by forces_job_init()
+ * @param index the index of the body, in the order the job was given them
+ * @return the body
  */
-list_t *force_job_get_bodies(force_job_t *force_job);
+body_t *forces_job_get_body(force_job_t *force_job, size_t index);
 #endif // #ifndef __FORCES_H__
@@ -0,0 +1,72 @@
+#ifndef __GRAVITY_FIELD_H__
+#define __GRAVITY_FIELD_H__
+
+#include "scene.h"
+
+/**
+ * Newtonian gravity between every pair of a set of bodies, run as a single
+ * force creator instead of one per pair.
+ * Each tick, the field sorts the bodies into a quadtree and approximates each
+ * cell that is far enough away from a body by a point mass at the cell's
+ * center of mass (the Barnes-Hut method), so a tick costs O(n log n) rather
+ * than O(n^2). With few bodies it sums the exact pairwise forces instead.
+ * Like create_newtonian_gravity(), no force is applied between bodies closer
+ * than a small minimum distance.
+ *
+ * The field refers to its bodies by handle, so removing a body just drops it
+ * from the field. The scene owns the field and frees it with the scene.
+ */
+typedef struct gravity_field gravity_field_t;
+
+/**
+ * Adds a gravity field with no bodies to a scene.
+ *
+ * @param scene the scene containing the bodies
+ * @param G the gravitational proportionality constant
+ * @param opening_angle the largest ratio of a cell's width to its distance
+ *   from a body for which the cell is approximated by its center of mass.
+ *   0 computes the exact forces; around 0.5 is usually accurate to within a
+ *   percent, and larger values are faster but less accurate.
+ * @return the new gravity field
+ */
+gravity_field_t *create_gravity_field(scene_t *scene, double G,
+                                      double opening_angle);
+
+/**
+ * Adds a body to a gravity field, so it attracts and is attracted by every
+ * other body in the field. The body should have finite mass.
+ *
+ * @param field a pointer to a field returned from create_gravity_field()
+ * @param body the handle of a body in the field's scene
+ */
+void gravity_field_add_body(gravity_field_t *field, body_handle_t body);
+
+/**
+ * Changes the opening angle of a gravity field.
+ *
+ * @param field a pointer to a field returned from create_gravity_field()
+ * @param opening_angle the new opening angle; see create_gravity_field()
+ */
+void gravity_field_set_opening_angle(gravity_field_t *field,
+                                     double opening_angle);
+
+/**
+ * Gets the number of bodies in a gravity field that are still in the scene.
+ *
+ * @param field a pointer to a field returned from create_gravity_field()
+ * @return the number of bodies
+ */
+size_t gravity_field_num_bodies(gravity_field_t *field);
+
+/**
+ * Measures how far the forces the field applies are from the exact pairwise
+ * forces, at the bodies' current positions. Costs O(n^2), so it is meant for
+ * tuning the opening angle rather than for every tick. Applies no forces.
+ *
+ * @param field a pointer to a field returned from create_gravity_field()
+ * @return the root-mean-square error of the forces on the bodies, relative to
+ *   the root-mean-square of the exact forces; 0 if the exact forces are all 0
+ */
+double gravity_field_measure_error(gravity_field_t *field);
+
+#endif // #ifndef __GRAVITY_FIELD_H__
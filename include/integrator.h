@@ -0,0 +1,71 @@
+#ifndef __INTEGRATOR_H__
+#define __INTEGRATOR_H__
+
+#include <stddef.h>
+
+/**
+ * The schemes a scene can integrate its dynamic bodies with.
+ * Each tick, a body's acceleration is its accumulated force over its mass,
+ * and its impulse changes its velocity instantly.
+ */
+typedef enum {
+  /**
+   * Moves the body at the average of its old and new velocities, like
+   * body_tick(). This is the default.
+   */
+  INTEGRATOR_AVERAGE_VELOCITY,
+  /** Updates the velocity first, then moves the body at the new velocity */
+  INTEGRATOR_SEMI_IMPLICIT_EULER,
+  /**
+   * Velocity Verlet: the position is advanced with the acceleration at the
+   * start of the tick, and the velocity with the average of the
+   * accelerations at the start of this tick and the last one.
+   */
+  INTEGRATOR_VELOCITY_VERLET,
+  /**
+   * The exact motion under an acceleration that is constant over the tick,
+   * e.g. an arrow under gravity, for any dt.
+   */
+  INTEGRATOR_CONSTANT_ACCELERATION,
+} integrator_t;
+
+/**
+ * The state of many bodies along one axis, stored as parallel arrays so the
+ * integrator can update several bodies per instruction.
+ * Element i of each array belongs to the same body.
+ */
+typedef struct {
+  /** The velocity at the start of the tick, replaced by the new velocity */
+  double *velocity;
+  /** The force accumulated during the tick */
+  const double *force;
+  /** The impulse accumulated during the tick */
+  const double *impulse;
+  /** The reciprocal of the mass (0 for infinite mass) */
+  const double *inv_mass;
+  /**
+   * The acceleration during the last tick, or during this one if the body
+   * has not been ticked since its velocity was set.
+   * Only read by INTEGRATOR_VELOCITY_VERLET.
+   */
+  const double *last_acceleration;
+  /** Filled in with how far the body moves during the tick */
+  double *displacement;
+} integrator_axis_t;
+
+/**
+ * Integrates the velocities and displacements of many bodies along one axis.
+ * INTEGRATOR_AVERAGE_VELOCITY gives the same results as body_tick() bit for
+ * bit, and uses SSE2 or AVX on native builds and WASM SIMD under emscripten
+ * when the compiler enables them. The other schemes are written as plain
+ * loops for the compiler to vectorize.
+ *
+ * @param integrator the scheme to integrate with
+ * @param axis the arrays to read and update
+ * @param size the number of bodies in each array
+ * @param dt the number of seconds elapsed since the last tick
+ */
+void integrator_step(integrator_t integrator, integrator_axis_t axis,
+                     size_t size, double dt);
+
+#endif // #ifndef __INTEGRATOR_H__
@@ -8,6 +8,7 @@
 #include "scene.h"
 #include "body.h"
 #include "vector.h"
+#include "vector_field.h"
 
 
 /**
@@ -74,6 +75,8 @@ typedef struct level_info {
     size_t ai_difficulty;
     vector_t character_2_velocity;
     vector_t level_gravity;
+    // wind and other accelerations on the arrows, or NULL for still air
+    const vector_field_t *wind;
 } level_info_t;
 
 /**
@@ -137,6 +140,15 @@ void skin_screen_free(skin_screen_t *screen);
 */
 level_t *level_init(level_info_t level_info);
 
+/**
+ * Starts timing a level from now. Must be called whenever the game switches
+ * to the level, so the first level_main() does not count the time spent
+ * elsewhere.
+ *
+ * @param level the level being switched to
+ */
+void level_enter(level_t *level);
+
 /**
  * Renders all the assets in the level_t object and also runs the functionality of
  * game. Caller should call sdl_clear and sdl_show before and after usage 
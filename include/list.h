@@ -2,6 +2,7 @@
 #define __LIST_H__
 
 #include "vector.h"
+#include <stdbool.h>
 #include <stddef.h>
 
 /**
@@ -65,6 +66,24 @@ void *list_get(list_t *list, size_t index);
  */
 void *list_remove(list_t *list, size_t index);
 
+/**
+ * A predicate on an element of a list.
+ * Takes in an auxiliary value that can store parameters or state.
+ */
+typedef bool (*list_pred_t)(void *value, void *aux);
+
+/**
+ * Removes every element of a list that matches a predicate, in a single pass
+ * that preserves the order of the remaining elements. Removed elements are
+ * freed with the list's freer, if it has one.
+ *
+ * @param list a pointer to a list returned from list_init()
+ * @param should_remove the predicate for elements to remove
+ * @param aux an auxiliary value to pass to should_remove
+ * @return the number of elements removed
+ */
+size_t list_remove_if(list_t *list, list_pred_t should_remove, void *aux);
+
 /**
  * Appends an element to the end of a list.
  * If the list is filled to capacity, resizes the list to fit more elements
@@ -2,17 +2,63 @@
 #define __POLYGON_H__
 
 #include "color.h"
-#include "list.h"
 #include "vector.h"
+#include <stdbool.h>
+#include <stddef.h>
 
 typedef struct polygon polygon_t;
 
 /**
- * Initialize a polygon object given a list of vertices.
+ * A read-only view of a polygon's vertices, stored contiguously in
+ * counterclockwise order. The view does not own the vertices and is only
+ * valid until the polygon is changed or freed.
+ */
+typedef struct {
+  const vector_t *points;
+  size_t size;
+} shape_view_t;
+
+/**
+ * An axis-aligned bounding box, given by its minimum and maximum corners.
+ */
+typedef struct {
+  vector_t min;
+  vector_t max;
+} aabb_t;
+
+/**
+ * The kinds of shape a polygon can have, detected when it is created.
+ * Collision detection uses this to pick a specialized test.
+ */
+typedef enum {
+  /** Any convex polygon */
+  POLYGON_CONVEX,
+  /** A rectangle, at any rotation */
+  POLYGON_BOX
+} polygon_kind_t;
+
+// The number of side directions of a box
+enum { BOX_NUM_AXES = 2 };
+
+/**
+ * A rectangle in world space, given by its center, the unit vectors along
+ * its two sides, and half its length along each of them.
+ */
+typedef struct {
+  vector_t center;
+  vector_t axes[BOX_NUM_AXES];
+  double half_extents[BOX_NUM_AXES];
+} box_t;
+
+/**
+ * Initialize a polygon object given an array of vertices.
+ * The vertices are copied into the polygon, which stores them in the same
+ * allocation as the polygon itself. They are kept in local space, relative to
+ * the centroid, and the polygon starts with its centroid at the centroid of
+ * the given vertices and a rotation of 0.
  *
- * @param points the list of vertices that make up the polygon
- * @param initial_position a vector representing the initial center position of
- * the polygon
+ * @param points the array of vertices that make up the polygon
+ * @param num_points the number of vertices in points
  * @param initial_velocity a vector representing the initial velocity of the
  * polygon
  * @param rotation_speed the rotation angle of the polygon per unit time
@@ -22,17 +68,105 @@ typedef struct polygon polygon_t;
  * @param blue double value between 0 and 1 representing the blue of the polygon
  * @return a polygon object pointer
  */
-polygon_t *polygon_init(list_t *points, vector_t initial_velocity,
-                        double rotation_speed, double red, double green,
-                        double blue);
+polygon_t *polygon_init(const vector_t *points, size_t num_points,
+                        vector_t initial_velocity, double rotation_speed,
+                        double red, double green, double blue);
 
 /**
- * Return the list of vectors representing the vertices of the polygon.
+ * Gets the number of bytes a polygon with a given number of vertices takes,
+ * for callers that provide the memory to polygon_init_in().
  *
- * @param polygon the list of vertices that make up the polygon
- * @return a list of vectors
+ * @param num_points the number of vertices of the polygon
+ * @return the size of the polygon in bytes
+ */
+size_t polygon_size(size_t num_points);
+
+/**
+ * Initializes a polygon like polygon_init(), but in memory provided by the
+ * caller, e.g. the end of a body. Such a polygon must not be passed to
+ * polygon_free(); the caller releases the memory once it is done with it.
+ *
+ * @param memory at least polygon_size(num_points) bytes, aligned for any type
+ * @param points the array of vertices that make up the polygon
+ * @param num_points the number of vertices in points
+ * @param initial_velocity the initial velocity of the polygon
+ * @param rotation_speed the rotation angle of the polygon per unit time
+ * @param red the red of the polygon, between 0 and 1
+ * @param green the green of the polygon, between 0 and 1
+ * @param blue the blue of the polygon, between 0 and 1
+ * @return a pointer to the polygon, which is at the start of memory
+ */
+polygon_t *polygon_init_in(void *memory, const vector_t *points,
+                           size_t num_points, vector_t initial_velocity,
+                           double rotation_speed, double red, double green,
+                           double blue);
+
+/**
+ * Return a view of the world-space vertices of the polygon.
+ * The vertices are recomputed from the polygon's position and rotation if it
+ * has moved since they were last read.
+ *
+ * @param polygon a polygon_t struct
+ * @return a view of the polygon's vertices
+ */
+shape_view_t polygon_get_view(polygon_t *polygon);
+
+/**
+ * Return a view of the local-space vertices of the polygon, i.e. relative to
+ * its centroid and before rotation. These never change after polygon_init().
+ *
+ * @param polygon a polygon_t struct
+ * @return a view of the polygon's local vertices
+ */
+shape_view_t polygon_get_local_view(polygon_t *polygon);
+
+/**
+ * Returns the kind of shape the polygon has.
+ *
+ * @param polygon a polygon_t struct
+ * @return POLYGON_BOX if the polygon is a rectangle, POLYGON_CONVEX otherwise
+ */
+polygon_kind_t polygon_get_kind(polygon_t *polygon);
+
+/**
+ * Returns the polygon as a box in world space. This is O(1).
+ * Asserts that the polygon's kind is POLYGON_BOX.
+ *
+ * @param polygon a polygon_t struct
+ * @return the box describing the polygon's current position
+ */
+box_t polygon_get_box(polygon_t *polygon);
+
+/**
+ * Returns the unit normals of the polygon's edges in world space, where
+ * normal i belongs to the edge between vertex i and vertex i + 1.
+ * The normals are computed once when the polygon is created and only rotated
+ * again after the polygon rotates; translation does not change them.
+ * The array is owned by the polygon and is only valid until it is changed or
+ * freed.
+ *
+ * @param polygon a polygon_t struct
+ * @return an array of polygon_num_points() unit normals
+ */
+const vector_t *polygon_get_normals(polygon_t *polygon);
+
+/**
+ * Returns the number of vertices in the polygon.
+ *
+ * @param polygon a polygon_t struct
+ * @return the number of vertices
+ */
+size_t polygon_num_points(polygon_t *polygon);
+
+/**
+ * Returns the vertex at the given index without copying the polygon.
+ * Asserts that the index is valid.
+ *
+ * @param polygon a polygon_t struct
+ * @param index the index of the vertex, in counterclockwise order
+ * @return the vertex at that index
  */
-list_t *polygon_get_points(polygon_t *polygon);
+vector_t polygon_get_point(polygon_t *polygon, size_t index);
 
 /**
  * Translate and rotate the polygon then update velocity based on gravity.
@@ -43,8 +177,10 @@ list_t *polygon_get_points(polygon_t *polygon);
 void polygon_move(polygon_t *polygon, double time_elapsed);
 
 /**
- * Computes the area of a polygon.
+ * Returns the area of a polygon.
  * See https://en.wikipedia.org/wiki/Shoelace_formula#Statement.
+ * The area is computed once when the polygon is created and cached, since
+ * translations and rotations do not change it.
  *
  * @param polygon the list of vertices that make up the polygon,
  * listed in a counterclockwise direction. There is an edge between
@@ -54,8 +190,9 @@ void polygon_move(polygon_t *polygon, double time_elapsed);
 double polygon_area(polygon_t *polygon);
 
 /**
- * Computes the center of mass of a polygon.
+ * Returns the center of mass of a polygon.
  * See https://en.wikipedia.org/wiki/Centroid#Of_a_polygon.
+ * The centroid is cached and moved along with the polygon, so this is O(1).
  *
  * @param polygon the list of vertices that make up the polygon,
  * listed in a counterclockwise direction. There is an edge between
@@ -64,8 +201,28 @@ double polygon_area(polygon_t *polygon);
  */
 vector_t polygon_centroid(polygon_t *polygon);
 
+/**
+ * Returns the axis-aligned bounding box of a polygon.
+ * The box is cached: translations shift it directly, while rotations mark it
+ * stale so that it is recomputed from the vertices on the next call.
+ *
+ * @param polygon a polygon_t struct
+ * @return the bounding box of the polygon
+ */
+aabb_t polygon_get_aabb(polygon_t *polygon);
+
+/**
+ * Returns the axis-aligned bounding box the polygon would have with a
+ * rotation of 0, at its current position. This is O(1).
+ *
+ * @param polygon a polygon_t struct
+ * @return the unrotated bounding box of the polygon
+ */
+aabb_t polygon_get_unrotated_aabb(polygon_t *polygon);
+
 /**
  * Translates all vertices in a polygon by a given vector.
+ * Only the polygon's position is updated; the vertices are recomputed lazily.
  * Note: mutates the original polygon.
  *
  * @param polygon the list of vertices that make up the polygon
@@ -75,6 +232,8 @@ void polygon_translate(polygon_t *polygon, vector_t translation);
 
 /**
  * Rotates vertices in a polygon by a given angle about a given point.
+ * This moves the centroid about the point and adds the angle to the polygon's
+ * rotation; the vertices are recomputed lazily.
  * Note: mutates the original polygon.
  *
  * @param polygon the list of vertices that make up the polygon
@@ -86,6 +245,7 @@ void polygon_rotate(polygon_t *polygon, double angle, vector_t point);
 
 /**
  * Return the polygon's color.
+ * The color is stored in the polygon and is valid until the polygon is freed.
  *
  * @param polygon the list of vertices that make up the polygon
  * @return the rgb_color_t struct representing the color
@@ -94,9 +254,10 @@ rgb_color_t *polygon_get_color(polygon_t *polygon);
 
 /**
  * Changes the color of the polygon.
+ * The color is copied into the polygon and then freed with color_free().
  *
  * @param polygon a polygon_t struct
- * @param color a struct containing rgb values of the new color
+ * @param color a color returned from color_init()
  */
 void polygon_set_color(polygon_t *polygon, rgb_color_t *color);
 
@@ -0,0 +1,49 @@
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <stddef.h>
+
+/**
+ * A free-list allocator for blocks of one fixed size.
+ * Blocks are carved out of chunks allocated a batch at a time, and a released
+ * block goes onto a free list to be handed out again, so a pool that has
+ * grown to its working size no longer calls malloc(). Freeing the pool
+ * releases every chunk at once, whether or not its blocks were released.
+ */
+typedef struct pool pool_t;
+
+/**
+ * Allocates an empty pool.
+ * Asserts that the required memory is successfully allocated.
+ *
+ * @param block_size the number of bytes in each block
+ * @param blocks_per_chunk the number of blocks to allocate at a time
+ * @return the new pool
+ */
+pool_t *pool_init(size_t block_size, size_t blocks_per_chunk);
+
+/**
+ * Releases the memory of a pool and of every block allocated from it.
+ *
+ * @param pool a pointer to a pool returned from pool_init()
+ */
+void pool_free(pool_t *pool);
+
+/**
+ * Allocates a block from a pool, aligned for any type.
+ * Asserts that the required memory is successfully allocated.
+ *
+ * @param pool a pointer to a pool returned from pool_init()
+ * @return a pointer to the block
+ */
+void *pool_alloc(pool_t *pool);
+
+/**
+ * Returns a block to the pool it was allocated from, for reuse.
+ *
+ * @param pool a pointer to a pool returned from pool_init()
+ * @param block a pointer returned from pool_alloc() on the same pool
+ */
+void pool_release(pool_t *pool, void *block);
+
+#endif // #ifndef __POOL_H__
@@ -2,7 +2,12 @@
 #define __SCENE_H__
 
 #include "body.h"
+#include "collision.h"
+#include "integrator.h"
 #include "list.h"
+#include "thread_pool.h"
+#include "vector_field.h"
+#include <stdint.h>
 
 /**
  * A collection of bodies and force creators.
@@ -11,6 +16,18 @@
  */
 typedef struct scene scene_t;
 
+/**
+ * A stable reference to a body in a scene.
+ * Unlike a body pointer or index, a handle can be kept after the body is
+ * removed: it then no longer resolves, even if its slot is reused.
+ */
+typedef struct {
+  /** The slot the body occupies in the scene */
+  uint32_t index;
+  /** The generation of the slot when the body was added */
+  uint32_t generation;
+} body_handle_t;
+
 /**
  * A function which adds some forces or impulses to bodies,
  * e.g. from collisions, gravity, or spring forces.
@@ -35,6 +52,22 @@ scene_t *scene_init(void);
  */
 void scene_free(scene_t *scene);
 
+/**
+ * Sets the scheme the scene integrates its dynamic bodies with.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param integrator the scheme to use; INTEGRATOR_AVERAGE_VELOCITY by default
+ */
+void scene_set_integrator(scene_t *scene, integrator_t integrator);
+
+/**
+ * Gets the scheme the scene integrates its dynamic bodies with.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the scheme set with scene_set_integrator()
+ */
+integrator_t scene_get_integrator(scene_t *scene);
+
 /**
  * Gets the number of bodies in a given scene.
  *
@@ -43,9 +76,21 @@ void scene_free(scene_t *scene);
  */
 size_t scene_bodies(scene_t *scene);
 
+/**
+ * Gets the pool the scene's bodies should be allocated from with
+ * body_init_in_pool(). The pool is freed with the scene, so its bodies must
+ * be added to the scene or freed before then.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the scene's body pool
+ */
+body_pool_t *scene_get_body_pool(scene_t *scene);
+
 /**
  * Gets the body at a given index in a scene.
  * Asserts that the index is valid.
+ * Indices are only valid until the next scene_tick(), since removing a body
+ * moves the last body into its place.
  *
  * @param scene a pointer to a scene returned from scene_init()
  * @param index the index of the body in the scene (starting at 0)
@@ -58,8 +103,19 @@ body_t *scene_get_body(scene_t *scene, size_t index);
  *
  * @param scene a pointer to a scene returned from scene_init()
  * @param body a pointer to the body to add to the scene
+ * @return a handle to the body, for use with scene_get_body_by_handle()
+ */
+body_handle_t scene_add_body(scene_t *scene, body_t *body);
+
+/**
+ * Looks up a body by the handle returned when it was added to a scene.
+ * Runs in constant time.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param handle a handle returned from scene_add_body()
+ * @return the body, or NULL if it has been removed from the scene
  */
-void scene_add_body(scene_t *scene, body_t *body);
+body_t *scene_get_body_by_handle(scene_t *scene, body_handle_t handle);
 
 /**
  * @deprecated Use body_remove() instead
@@ -74,7 +130,8 @@ void scene_remove_body(scene_t *scene, size_t index);
 
 /**
  * @deprecated Use scene_add_bodies_force_creator() instead
- * so the scene knows which bodies the force creator depends on
+ * so the scene knows which bodies the force creator depends on.
+ * The scene does not free aux.
  */
 void scene_add_force_creator(scene_t *scene, force_creator_t forcer, void *aux);
 
@@ -91,16 +148,138 @@ void scene_add_force_creator(scene_t *scene, force_creator_t forcer, void *aux);
  * @param bodies the list of bodies affected by the force creator.
  *   The force creator will be removed if any of these bodies are removed.
  *   This list does not own the bodies, so its freer should be NULL.
+ *   The scene copies the bodies and frees the list.
+ * @param aux_freer the function that frees aux when the force creator is
+ *   removed, or NULL if the scene should not free aux
+ * @return the new force job, which the scene owns
+ */
+struct force_job *scene_add_bodies_force_creator(scene_t *scene,
+                                                 force_creator_t forcer,
+                                                 void *aux, list_t *bodies,
+                                                 free_func_t aux_freer);
+
+/**
+ * Adds a force job built with forces_job_init() to a scene, like
+ * scene_add_bodies_force_creator(). The scene takes ownership of the job.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param job the force job to run every tick
+ */
+void scene_add_force_job(scene_t *scene, struct force_job *job);
+
+/**
+ * Adds a force creator like scene_add_bodies_force_creator() that may run on
+ * the scene's thread pool, concurrently with other such force creators.
+ * It must only read the bodies' centroids, velocities and masses, and only
+ * change them with body_add_force() and body_add_impulse(). The forces are
+ * applied in the same order as if every force creator ran on one thread, so
+ * the results do not depend on the number of threads.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param forcer a force creator function
+ * @param aux an auxiliary value to pass to forcer when it is called
+ * @param bodies the list of bodies affected by the force creator
+ * @param aux_freer the function that frees aux, or NULL
+ * @return the new force job, which the scene owns
+ */
+struct force_job *scene_add_parallel_force_creator(scene_t *scene,
+                                                   force_creator_t forcer,
+                                                   void *aux, list_t *bodies,
+                                                   free_func_t aux_freer);
+
+/**
+ * Sets the thread pool the scene runs parallel force creators and body
+ * integration on. Without one (the default), scene_tick() runs on the
+ * calling thread.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param pool a thread pool, or NULL. The scene does not free it.
+ */
+void scene_set_thread_pool(scene_t *scene, thread_pool_t *pool);
+
+/**
+ * Sets a field of accelerations, e.g. wind, that acts on every dynamic body
+ * in the scene. Each tick, the field is sampled at every dynamic body's
+ * centroid in one batch while the bodies are integrated, so it costs no
+ * force creators. Animated fields are sampled at the total time the scene
+ * has been ticked for.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param field the field, or NULL for none (the default).
+ *   The scene does not free it.
+ */
+void scene_set_vector_field(scene_t *scene, const vector_field_t *field);
+
+/**
+ * Gets the field of accelerations acting on the scene's dynamic bodies.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the field passed to scene_set_vector_field(), or NULL for none
+ */
+const vector_field_t *scene_get_vector_field(scene_t *scene);
+
+/**
+ * Gets the total time the scene has been ticked for, which animated vector
+ * fields are sampled at.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the sum of the dt passed to scene_tick(), in seconds
+ */
+double scene_get_time(scene_t *scene);
+
+/**
+ * Registers a collision between every body in one category and every body in
+ * another, without creating a force creator per pair.
+ * Each tick, the scene finds the pairs of bodies whose bounding boxes overlap
+ * (the broadphase) and only runs find_collision() on those pairs.
+ * The handler is called once when a pair starts colliding, with the body in
+ * category_a as body1; it is not called again until the pair separates.
+ * Bodies are only considered if they were given a category with
+ * body_set_category().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param category_a a bitmask of the categories of the first body
+ * @param category_b a bitmask of the categories of the second body
+ * @param handler the function to call when a pair collides
+ * @param aux an auxiliary value to pass to the handler.
+ *   The scene does not free it.
+ * @param force_const a constant to pass to the handler
+ */
+void scene_add_category_collision(scene_t *scene, body_category_t category_a,
+                                  body_category_t category_b,
+                                  collision_handler_t handler, void *aux,
+                                  double force_const);
+
+/**
+ * Adds a half-plane bounding the world, e.g. a wall or the ground.
+ * The inside of the world is every point p with dot(normal, p) >= offset.
+ * Each tick, the vertices of every body in the given categories are tested
+ * against the bound, and the handler is called once when a body starts
+ * crossing it. The handler receives the body as body1, NULL as body2, and
+ * the axis -normal, pointing out of the world.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param normal the unit normal of the bound, pointing into the world
+ * @param offset the value of dot(normal, p) for points p on the bound
+ * @param category a bitmask of the categories of bodies the bound stops
+ * @param handler the function to call when a body crosses the bound
+ * @param aux an auxiliary value to pass to the handler.
+ *   The scene does not free it.
+ * @param force_const a constant to pass to the handler
  */
-void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
-                                    void *aux, list_t *bodies);
+void scene_add_bound(scene_t *scene, vector_t normal, double offset,
+                     body_category_t category, collision_handler_t handler,
+                     void *aux, double force_const);
 
 /**
  * Executes a tick of a given scene over a small time interval.
- * This requires executing all the force creators
- * and then ticking each body (see body_tick()).
+ * This requires executing all the force creators, handling any new collisions
+ * between categories or with the world bounds, and then ticking each body
+ * according to its type (see body_tick() and body_set_type()).
  * If any bodies are marked for removal, they should be removed from the scene
  * and freed, along with any force creators acting on them.
+ * Removing a body moves the last body into its index, so the order of the
+ * remaining bodies is not preserved.
  *
  * @param scene a pointer to a scene returned from scene_init()
  * @param dt the time elapsed since the last tick, in seconds
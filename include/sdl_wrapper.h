@@ -21,6 +21,9 @@ typedef enum {
   SPACE_BAR = 5,
 } arrow_key_t;
 
+// The number of vertices written by sdl_make_rectangle()
+enum { RECT_NUM_POINTS = 4 };
+
 // Values passed to a key handler when the given arrow key is pressed
 typedef enum {
   DRAW_BOW = 0,
@@ -84,6 +87,19 @@ typedef void (*level_mouse_handler_t)(level_t *level, double x_loc, double y_loc
 */
 typedef struct sdl_mouse_handlers sdl_mouse_handlers_t;
 
+/**
+ * Counters for the rendering work done in a single frame.
+ * A frame runs from one sdl_clear() to the next.
+ */
+typedef struct {
+  /** The number of draw commands issued to the renderer */
+  size_t draw_calls;
+  /** The number of times the renderer was presented */
+  size_t presents;
+  /** The number of heap allocations the library made; see alloc.h */
+  size_t allocations;
+} sdl_frame_stats_t;
+
 /**
  * Initializes the SDL window and renderer.
  * Must be called once before any of the other SDL functions.
@@ -113,7 +129,8 @@ void sdl_set_mouse_handlers(state_mouse_handler_t screen_switch, state_mouse_han
 bool sdl_is_done(void *state);
 
 /**
- * Clears the screen. Should be called before drawing polygons in each frame.
+ * Clears the screen and empties the render queue.
+ * Should be called once at the start of each frame.
  */
 void sdl_clear(void);
 
@@ -126,14 +143,73 @@ void sdl_clear(void);
 void sdl_draw_polygon(polygon_t *poly, rgb_color_t color);
 
 /**
- * Displays the rendered frame on the SDL window.
- * Must be called after drawing the polygons in order to show them.
+ * Draws everything in the render queue, sorted by layer and then by the order
+ * it was queued in, and displays the rendered frame on the SDL window.
+ * Should be called once at the end of each frame.
  */
 void sdl_show(void);
 
+/**
+ * Queues an image to be drawn on the next sdl_show().
+ * Commands in lower layers are drawn first. Within a layer, commands are
+ * drawn in the order they were queued, so queue draws of one texture back to
+ * back where the overlap allows it.
+ *
+ * @param img pointer to the texture to draw
+ * @param bounds the dimensions and parameters of the image
+ * @param rot angle to rotate the image, in radians (0 for no rotation)
+ * @param layer the z-layer to draw the image in
+ */
+void sdl_queue_image(SDL_Texture *img, SDL_Rect bounds, double rot,
+                     size_t layer);
+
+/**
+ * Queues a polygon to be drawn on the next sdl_show().
+ * The vertices are converted to pixels immediately, so the polygon may be
+ * changed or freed after this call.
+ *
+ * @param poly a struct representing the polygon
+ * @param color the color used to fill in the polygon
+ * @param layer the z-layer to draw the polygon in
+ */
+void sdl_queue_polygon(polygon_t *poly, rgb_color_t color, size_t layer);
+
+/**
+ * Queues a polygon to be drawn on the next sdl_show(), translated by an
+ * offset, e.g. to draw a body between two physics states.
+ *
+ * @param poly a struct representing the polygon
+ * @param offset how far from its current position to draw the polygon
+ * @param color the color used to fill in the polygon
+ * @param layer the z-layer to draw the polygon in
+ */
+void sdl_queue_polygon_at(polygon_t *poly, vector_t offset, rgb_color_t color,
+                          size_t layer);
+
+/**
+ * Queues text to be drawn on the next sdl_show().
+ * The text is not copied, so it must stay valid until sdl_show() is called.
+ *
+ * @param text text to draw
+ * @param font font style of the text
+ * @param color the color for the text
+ * @param bounds the dimensions and parameters of the text
+ * @param layer the z-layer to draw the text in
+ */
+void sdl_queue_text(const char *text, TTF_Font *font, rgb_color_t color,
+                    SDL_Rect bounds, size_t layer);
+
+/**
+ * Returns the counters for the last completed frame, i.e. the work done
+ * between the two most recent calls to sdl_clear().
+ *
+ * @return the frame stats of the last frame
+ */
+sdl_frame_stats_t sdl_get_frame_stats(void);
+
 /**
  * Draws all bodies in a scene.
- * This internally calls sdl_clear(), sdl_draw_polygon(), and sdl_show(),
+ * This internally calls sdl_clear(), sdl_queue_polygon(), and sdl_show(),
  * so those functions should not be called directly.
  *
  * @param scene the scene to draw
@@ -170,8 +246,9 @@ void sdl_render_scene(scene_t *scene, void *aux);
 void sdl_on_key(key_handler_t handler);
 
 /**
- * Gets the amount of time that has passed since the last time
- * this function was called, in seconds.
+ * Gets the amount of wall-clock time that has passed since the last time
+ * this function was called, in seconds, measured with a monotonic
+ * high-resolution clock. Returns 0 the first time it is called.
  *
  * @return the number of seconds that have elapsed
  */
@@ -274,6 +351,23 @@ SDL_Rect sdl_get_bounds(size_t h, size_t w, size_t x, size_t y);
  */
 SDL_Rect bounding_box(body_t *body);
 
+/**
+ * Converts a box in scene coordinates to the window's coordinates.
+ *
+ * @param aabb the box to convert
+ * @return an SDL_Rect object with the dimensions of the box
+ */
+SDL_Rect sdl_aabb_to_rect(aabb_t aabb);
+
+/**
+ * Returns the bounding box a body would have if it were not rotated, e.g. for
+ * drawing a texture that is then rotated by the body's angle.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return an SDL_Rect object with the dimensions for the bounding box
+ */
+SDL_Rect unrotated_bounding_box(body_t *body);
+
 /**
  * Checks if a location on the screen, given by inputs x and y, is contained
  * within a bounding box
@@ -286,14 +380,16 @@ SDL_Rect bounding_box(body_t *body);
 bool sdl_contained_in_box(double x, double y, SDL_Rect bounding_box);
 
 /**
- * Return a list of coordinates corresponding to a rectangle
+ * Writes the vertices of a rectangle into an array, in the order top left,
+ * top right, bottom right, bottom left.
  * 
  * @param x the x coordinate of the top left
  * @param y the y coordinate of the top left
  * @param w the width of the rectangle
  * @param h the height of the rectangle
- * @return list of vectors used to define the rectangle
+ * @param rect an array with room for RECT_NUM_POINTS vectors
 */ 
-list_t *sdl_make_rectangle(double x, double y, double w, double h);
+void sdl_make_rectangle(double x, double y, double w, double h,
+                        vector_t *rect);
 
 #endif // #ifndef __SDL_WRAPPER_H__
@@ -0,0 +1,70 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <stddef.h>
+
+/**
+ * A fixed set of worker threads that split loops between them.
+ * Each call to thread_pool_parallel_for() cuts its range into chunks and
+ * deals them out evenly; a worker that runs out of chunks steals from the
+ * others, so uneven chunks still keep every worker busy.
+ *
+ * Builds without thread support (e.g. emscripten without -pthread) get a
+ * pool that runs every loop on the calling thread.
+ */
+typedef struct thread_pool thread_pool_t;
+
+/**
+ * A chunk of work in a parallel loop, covering the indices [begin, end).
+ * Chunks of the same loop may run concurrently, in any order.
+ *
+ * @param aux the auxiliary value passed to thread_pool_parallel_for()
+ * @param begin the first index in the chunk
+ * @param end one past the last index in the chunk
+ */
+typedef void (*parallel_task_t)(void *aux, size_t begin, size_t end);
+
+/**
+ * Starts a thread pool.
+ * Asserts that the required memory and threads are successfully allocated.
+ *
+ * @param num_workers the number of threads to run loops on, counting the
+ *   thread that calls thread_pool_parallel_for(); 1 runs everything on the
+ *   calling thread
+ * @return the new thread pool
+ */
+thread_pool_t *thread_pool_init(size_t num_workers);
+
+/**
+ * Stops the threads of a thread pool and releases its memory.
+ *
+ * @param pool a pointer to a thread pool returned from thread_pool_init()
+ */
+void thread_pool_free(thread_pool_t *pool);
+
+/**
+ * Gets the number of threads a pool runs loops on.
+ *
+ * @param pool a pointer to a thread pool returned from thread_pool_init()
+ * @return the number of workers, including the calling thread
+ */
+size_t thread_pool_num_workers(thread_pool_t *pool);
+
+/**
+ * Runs a task over the indices [0, count) in chunks of chunk_size indices
+ * (the last chunk may be smaller), and waits for every chunk to finish.
+ * The chunks only depend on count and chunk_size, not on the number of
+ * workers. Must not be called from inside a task.
+ *
+ * @param pool a pointer to a thread pool returned from thread_pool_init(),
+ *   or NULL to run the loop on the calling thread
+ * @param count the number of indices
+ * @param chunk_size the number of indices in each chunk; must be positive
+ * @param task the function to run on each chunk
+ * @param aux an auxiliary value to pass to the task
+ */
+void thread_pool_parallel_for(thread_pool_t *pool, size_t count,
+                              size_t chunk_size, parallel_task_t task,
+                              void *aux);
+
+#endif // #ifndef __THREAD_POOL_H__
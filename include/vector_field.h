@@ -0,0 +1,67 @@
+#ifndef __VECTOR_FIELD_H__
+#define __VECTOR_FIELD_H__
+
+#include <stddef.h>
+
+#include "vector.h"
+
+/**
+ * An acceleration that varies over space and time, e.g. wind, updrafts or
+ * vortices, stored as a coarse grid of samples.
+ * Between samples the field is interpolated bilinearly, and outside the
+ * grid it takes the value of the nearest edge.
+ * An animated field stores several frames of the grid and blends linearly
+ * from one to the next, looping back to the first after the last.
+ *
+ * vector_field_t is defined here so levels can declare fields as constants;
+ * the field does not own its samples.
+ */
+typedef struct {
+  /** The position of the first sample, at the bottom-left of the grid */
+  vector_t origin;
+  /** The distance between neighbouring samples along x and y */
+  double spacing;
+  /** The number of samples in each row; at least 1 */
+  size_t columns;
+  /** The number of rows of samples; at least 1 */
+  size_t rows;
+  /** The number of frames; 1 for a field that does not change over time */
+  size_t num_frames;
+  /** The number of seconds from one frame to the next */
+  double frame_duration;
+  /**
+   * The accelerations, num_frames * rows * columns of them. Frames are
+   * stored one after another, each row by row from the bottom.
+   */
+  const vector_t *samples;
+} vector_field_t;
+
+/**
+ * Samples a field at many positions at once.
+ * The positions and results are parallel arrays, so the loop can be
+ * vectorized.
+ *
+ * @param field the field to sample
+ * @param time the number of seconds since the field started; not negative
+ * @param x the x coordinates of the positions
+ * @param y the y coordinates of the positions
+ * @param out_x filled in with the x components of the field
+ * @param out_y filled in with the y components of the field
+ * @param size the number of positions
+ */
+void vector_field_sample(const vector_field_t *field, double time,
+                         const double *x, const double *y, double *out_x,
+                         double *out_y, size_t size);
+
+/**
+ * Samples a field at one position.
+ *
+ * @param field the field to sample
+ * @param time the number of seconds since the field started
+ * @param position the position to sample at
+ * @return the field's value at the position
+ */
+vector_t vector_field_at(const vector_field_t *field, double time,
+                         vector_t position);
+
+#endif // #ifndef __VECTOR_FIELD_H__
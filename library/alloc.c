@@ -0,0 +1,368 @@
+#include <assert.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// this file calls the real allocator
+#define ALLOC_NO_REDIRECT
+#include "alloc.h"
+
+#ifdef ALLOC_TRACKING
+// emscripten only has threads when built with -pthread
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define ALLOC_SERIAL
+#else
+#include <pthread.h>
+#endif
+#endif
+
+// the most call sites alloc_report() lists
+const size_t ALLOC_REPORT_MAX_SITES = 20;
+
+const char *const ALLOC_TAG_NAMES[NUM_ALLOC_TAGS] = {
+    [ALLOC_TAG_PHYSICS] = "physics", [ALLOC_TAG_RENDER] = "render",
+    [ALLOC_TAG_ASSETS] = "assets",   [ALLOC_TAG_LEVEL] = "level",
+    [ALLOC_TAG_CORE] = "core"};
+
+/**
+ * The allocations made and bytes requested by a subsystem. Worker threads
+ * allocate too, e.g. when a force buffer grows, so these are atomic.
+ */
+typedef struct {
+  atomic_size_t allocations;
+  atomic_size_t bytes;
+} tag_counts_t;
+
+/**
+ * The churn of a subsystem over the frames recorded by alloc_end_frame().
+ */
+typedef struct {
+  // the counts as of the end of the first frame, which includes everything
+  // allocated at startup, and as of the end of the last frame
+  size_t first_allocations;
+  size_t first_bytes;
+  size_t last_allocations;
+  size_t last_bytes;
+  size_t max_allocations;
+  size_t max_bytes;
+} tag_churn_t;
+
+tag_counts_t tag_counts[NUM_ALLOC_TAGS];
+tag_churn_t tag_churn[NUM_ALLOC_TAGS];
+size_t num_frames = 0;
+
+static void count_allocation(alloc_tag_t tag, size_t size) {
+  assert(tag < NUM_ALLOC_TAGS);
+  atomic_fetch_add_explicit(&tag_counts[tag].allocations, 1,
+                            memory_order_relaxed);
+  atomic_fetch_add_explicit(&tag_counts[tag].bytes, size,
+                            memory_order_relaxed);
+}
+
+#ifdef ALLOC_TRACKING
+
+/**
+ * Precedes each live allocation, linking it into the live set.
+ */
+typedef struct live_header {
+  struct live_header *previous;
+  struct live_header *next;
+  size_t size;
+  const char *site;
+  alloc_tag_t tag;
+  alignas(max_align_t) unsigned char data[];
+} live_header_t;
+
+/**
+ * The live allocations made at one call site, as listed by alloc_report().
+ */
+typedef struct {
+  const char *site;
+  alloc_tag_t tag;
+  size_t allocations;
+  size_t bytes;
+} site_total_t;
+
+// the live allocations, most recent first
+live_header_t *live_set = NULL;
+size_t live_allocations[NUM_ALLOC_TAGS];
+size_t live_bytes[NUM_ALLOC_TAGS];
+bool report_registered = false;
+#ifndef ALLOC_SERIAL
+pthread_mutex_t live_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void lock_live_set(void) {
+#ifndef ALLOC_SERIAL
+  pthread_mutex_lock(&live_lock);
+#endif
+}
+
+static void unlock_live_set(void) {
+#ifndef ALLOC_SERIAL
+  pthread_mutex_unlock(&live_lock);
+#endif
+}
+
+static void report_at_exit(void) { alloc_report(stderr); }
+
+/**
+ * Adds an allocation to the live set. Must hold the lock.
+ */
+static void link_live(live_header_t *header) {
+  header->previous = NULL;
+  header->next = live_set;
+  if (live_set != NULL) {
+    live_set->previous = header;
+  }
+  live_set = header;
+  live_allocations[header->tag]++;
+  live_bytes[header->tag] += header->size;
+  if (!report_registered) {
+    atexit(report_at_exit);
+    report_registered = true;
+  }
+}
+
+/**
+ * Removes an allocation from the live set. Must hold the lock.
+ */
+static void unlink_live(live_header_t *header) {
+  if (header->previous != NULL) {
+    header->previous->next = header->next;
+  } else {
+    live_set = header->next;
+  }
+  if (header->next != NULL) {
+    header->next->previous = header->previous;
+  }
+  live_allocations[header->tag]--;
+  live_bytes[header->tag] -= header->size;
+}
+
+static live_header_t *get_header(void *pointer) {
+  return (live_header_t *)((unsigned char *)pointer -
+                           offsetof(live_header_t, data));
+}
+
+/**
+ * Fills in the header of a new allocation and adds it to the live set.
+ *
+ * @return the memory following the header, or NULL if header is NULL
+ */
+static void *track(live_header_t *header, size_t size, alloc_tag_t tag,
+                   const char *site) {
+  if (header == NULL) {
+    return NULL;
+  }
+  header->size = size;
+  header->site = site;
+  header->tag = tag;
+  lock_live_set();
+  link_live(header);
+  unlock_live_set();
+  return header->data;
+}
+
+void *alloc_malloc(size_t size, alloc_tag_t tag, const char *site) {
+  count_allocation(tag, size);
+  return track(malloc(sizeof(live_header_t) + size), size, tag, site);
+}
+
+void *alloc_calloc(size_t count, size_t size, alloc_tag_t tag,
+                   const char *site) {
+  assert(size == 0 || count <= SIZE_MAX / size);
+  count_allocation(tag, count * size);
+  return track(calloc(1, sizeof(live_header_t) + count * size), count * size,
+               tag, site);
+}
+
+void *alloc_realloc(void *pointer, size_t size, alloc_tag_t tag,
+                    const char *site) {
+  if (pointer == NULL) {
+    return alloc_malloc(size, tag, site);
+  }
+  count_allocation(tag, size);
+  live_header_t *header = get_header(pointer);
+  lock_live_set();
+  unlink_live(header);
+  live_header_t *resized = realloc(header, sizeof(live_header_t) + size);
+  if (resized == NULL) {
+    // the old memory is still allocated
+    link_live(header);
+    unlock_live_set();
+    return NULL;
+  }
+  resized->size = size;
+  resized->site = site;
+  resized->tag = tag;
+  link_live(resized);
+  unlock_live_set();
+  return resized->data;
+}
+
+void alloc_free(void *pointer) {
+  if (pointer == NULL) {
+    return;
+  }
+  live_header_t *header = get_header(pointer);
+  lock_live_set();
+  unlink_live(header);
+  unlock_live_set();
+  free(header);
+}
+
+/**
+ * Orders call sites by live bytes, largest first.
+ */
+static int compare_sites(const void *a, const void *b) {
+  size_t bytes_a = ((const site_total_t *)a)->bytes;
+  size_t bytes_b = ((const site_total_t *)b)->bytes;
+  return (bytes_a < bytes_b) - (bytes_a > bytes_b);
+}
+
+/**
+ * Prints the live allocations grouped by call site.
+ */
+static void report_live_set(FILE *out) {
+  lock_live_set();
+  size_t num_live = 0;
+  for (live_header_t *header = live_set; header != NULL;
+       header = header->next) {
+    num_live++;
+  }
+  site_total_t *sites = malloc((num_live + 1) * sizeof(site_total_t));
+  assert(sites != NULL);
+  size_t num_sites = 0;
+  for (live_header_t *header = live_set; header != NULL;
+       header = header->next) {
+    size_t i = 0;
+    while (i < num_sites && strcmp(sites[i].site, header->site) != 0) {
+      i++;
+    }
+    if (i == num_sites) {
+      sites[num_sites++] = (site_total_t){.site = header->site,
+                                          .tag = header->tag,
+                                          .allocations = 0,
+                                          .bytes = 0};
+    }
+    sites[i].allocations++;
+    sites[i].bytes += header->size;
+  }
+  unlock_live_set();
+
+  qsort(sites, num_sites, sizeof(site_total_t), compare_sites);
+  fprintf(out, "live allocations by call site:\n");
+  for (size_t i = 0; i < num_sites && i < ALLOC_REPORT_MAX_SITES; i++) {
+    fprintf(out, "  %-8s %8zu allocations %10zu bytes  %s\n",
+            ALLOC_TAG_NAMES[sites[i].tag], sites[i].allocations,
+            sites[i].bytes, sites[i].site);
+  }
+  if (num_sites > ALLOC_REPORT_MAX_SITES) {
+    fprintf(out, "  ... and %zu more call sites\n",
+            num_sites - ALLOC_REPORT_MAX_SITES);
+  }
+  free(sites);
+}
+
+#else
+
+void *alloc_malloc(size_t size, alloc_tag_t tag, const char *site) {
+  count_allocation(tag, size);
+  return malloc(size);
+}
+
+void *alloc_calloc(size_t count, size_t size, alloc_tag_t tag,
+                   const char *site) {
+  count_allocation(tag, count * size);
+  return calloc(count, size);
+}
+
+void *alloc_realloc(void *pointer, size_t size, alloc_tag_t tag,
+                    const char *site) {
+  count_allocation(tag, size);
+  return realloc(pointer, size);
+}
+
+void alloc_free(void *pointer) { free(pointer); }
+
+#endif // #ifdef ALLOC_TRACKING
+
+size_t alloc_get_count(void) {
+  size_t count = 0;
+  for (size_t i = 0; i < NUM_ALLOC_TAGS; i++) {
+    count += atomic_load_explicit(&tag_counts[i].allocations,
+                                  memory_order_relaxed);
+  }
+  return count;
+}
+
+alloc_stats_t alloc_get_stats(alloc_tag_t tag) {
+  assert(tag < NUM_ALLOC_TAGS);
+  alloc_stats_t stats = {
+      .allocations = atomic_load_explicit(&tag_counts[tag].allocations,
+                                          memory_order_relaxed),
+      .bytes =
+          atomic_load_explicit(&tag_counts[tag].bytes, memory_order_relaxed),
+      .live_allocations = 0,
+      .live_bytes = 0};
+#ifdef ALLOC_TRACKING
+  lock_live_set();
+  stats.live_allocations = live_allocations[tag];
+  stats.live_bytes = live_bytes[tag];
+  unlock_live_set();
+#endif
+  return stats;
+}
+
+const char *alloc_tag_name(alloc_tag_t tag) {
+  assert(tag < NUM_ALLOC_TAGS);
+  return ALLOC_TAG_NAMES[tag];
+}
+
+void alloc_end_frame(void) {
+  for (size_t i = 0; i < NUM_ALLOC_TAGS; i++) {
+    alloc_stats_t stats = alloc_get_stats(i);
+    tag_churn_t *churn = &tag_churn[i];
+    size_t allocations = stats.allocations - churn->last_allocations;
+    size_t bytes = stats.bytes - churn->last_bytes;
+    if (num_frames == 0) {
+      churn->first_allocations = stats.allocations;
+      churn->first_bytes = stats.bytes;
+    } else {
+      churn->max_allocations = allocations > churn->max_allocations
+                                   ? allocations
+                                   : churn->max_allocations;
+      churn->max_bytes = bytes > churn->max_bytes ? bytes : churn->max_bytes;
+    }
+    churn->last_allocations = stats.allocations;
+    churn->last_bytes = stats.bytes;
+  }
+  num_frames++;
+}
+
+void alloc_report(FILE *out) {
+  // churn is averaged over the frames after the first
+  double churn_frames = num_frames > 1 ? num_frames - 1 : 1;
+  fprintf(out, "allocations by subsystem over %zu frames:\n", num_frames);
+  fprintf(out, "  %-8s %12s %14s %10s %10s %12s %10s %12s\n", "",
+          "allocations", "bytes", "per frame", "max/frame", "max B/frame",
+          "live", "live bytes");
+  for (size_t i = 0; i < NUM_ALLOC_TAGS; i++) {
+    alloc_stats_t stats = alloc_get_stats(i);
+    tag_churn_t *churn = &tag_churn[i];
+    double per_frame =
+        (churn->last_allocations - churn->first_allocations) / churn_frames;
+    fprintf(out, "  %-8s %12zu %14zu %10.2f %10zu %12zu %10zu %12zu\n",
+            ALLOC_TAG_NAMES[i], stats.allocations, stats.bytes, per_frame,
+            churn->max_allocations, churn->max_bytes, stats.live_allocations,
+            stats.live_bytes);
+  }
+#ifdef ALLOC_TRACKING
+  report_live_set(out);
+#endif
+}
@@ -0,0 +1,98 @@
+#include <assert.h>
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#define ALLOC_TAG ALLOC_TAG_CORE
+#include "alloc.h"
+#include "arena.h"
+
+const size_t ARENA_GROWTH_FACTOR = 2;
+const size_t FRAME_ARENA_CAPACITY = 16384;
+
+/**
+ * A block of memory in an arena. The memory follows the header.
+ */
+typedef struct arena_block {
+  struct arena_block *previous;
+  size_t capacity;
+  alignas(max_align_t) unsigned char data[];
+} arena_block_t;
+
+struct arena {
+  // the block being allocated from; older blocks hang off it
+  arena_block_t *block;
+  size_t used;
+  // the sum of the capacities of all the blocks
+  size_t capacity;
+};
+
+arena_t *frame_arena = NULL;
+
+static arena_block_t *block_init(size_t capacity, arena_block_t *previous) {
+  arena_block_t *block = malloc(sizeof(arena_block_t) + capacity);
+  assert(block != NULL);
+  block->previous = previous;
+  block->capacity = capacity;
+  return block;
+}
+
+static void free_blocks(arena_block_t *block) {
+  while (block != NULL) {
+    arena_block_t *previous = block->previous;
+    free(block);
+    block = previous;
+  }
+}
+
+arena_t *arena_init(size_t capacity) {
+  arena_t *arena = malloc(sizeof(arena_t));
+  assert(arena != NULL);
+  arena->block = block_init(capacity, NULL);
+  arena->used = 0;
+  arena->capacity = capacity;
+  return arena;
+}
+
+void arena_free(arena_t *arena) {
+  free_blocks(arena->block);
+  free(arena);
+}
+
+void *arena_alloc(arena_t *arena, size_t size) {
+  size_t alignment = alignof(max_align_t);
+  size_t start = (arena->used + alignment - 1) / alignment * alignment;
+  if (start + size > arena->block->capacity) {
+    size_t capacity = arena->block->capacity * ARENA_GROWTH_FACTOR;
+    if (capacity < size) {
+      capacity = size;
+    }
+    arena->block = block_init(capacity, arena->block);
+    arena->capacity += capacity;
+    start = 0;
+  }
+  arena->used = start + size;
+  return &arena->block->data[start];
+}
+
+void arena_reset(arena_t *arena) {
+  // replace a chain of blocks with one block big enough for all of them
+  if (arena->block->previous != NULL) {
+    free_blocks(arena->block);
+    arena->block = block_init(arena->capacity, NULL);
+  }
+  arena->used = 0;
+}
+
+void *frame_alloc(size_t size) {
+  if (frame_arena == NULL) {
+    frame_arena = arena_init(FRAME_ARENA_CAPACITY);
+  }
+  return arena_alloc(frame_arena, size);
+}
+
+void frame_arena_reset(void) {
+  if (frame_arena != NULL) {
+    arena_reset(frame_arena);
+  }
+}
@@ -6,10 +6,18 @@
 #include "asset_cache.h"
 #include "color.h"
 #include "sdl_wrapper.h"
+#define ALLOC_TAG ALLOC_TAG_ASSETS
+#include "alloc.h"
+
+/**
+ * How far between the last two physics states bodies are drawn.
+ */
+double render_alpha = 1.0;
 
 typedef struct asset {
   asset_type_t type;
   SDL_Rect bounding_box;
+  asset_layer_t layer;
 } asset_t;
 
 typedef struct text_asset {
@@ -39,40 +47,18 @@ typedef struct button_asset {
 } button_asset_t;
 
 /**
- * Allocates memory for an asset with the given parameters.
+ * Initializes the fields shared by every type of asset.
  *
+ * @param asset the start of a newly allocated asset of the given type
  * @param ty the type of the asset
  * @param bounding_box the bounding box containing the location and dimensions
  * of the asset when it is rendered
- * @return a pointer to the newly allocated asset
  */
-static asset_t *asset_init(asset_type_t ty, SDL_Rect bounding_box) {
-  asset_t *new;
-  switch (ty) {
-  case ASSET_IMAGE: {
-    new = malloc(sizeof(image_asset_t));
-    break;
-  }
-  case ASSET_FONT: {
-    new = malloc(sizeof(text_asset_t));
-    break;
-  }
-  case ASSET_BUTTON: {
-    new = malloc(sizeof(button_asset_t));
-    break;
-  }
-  case ASSET_BODY: {
-    new = malloc(sizeof(body_asset_t));
-    break;
-  }
-  default: {
-    assert(false && "Unknown asset type");
-  }
-  }
-  assert(new);
-  new->type = ty;
-  new->bounding_box = bounding_box;
-  return new;
+static void asset_init(asset_t *asset, asset_type_t ty,
+                       SDL_Rect bounding_box) {
+  asset->type = ty;
+  asset->bounding_box = bounding_box;
+  asset->layer = LAYER_WORLD;
 }
 
 asset_type_t asset_get_type(asset_t *asset) { return asset->type; }
@@ -81,7 +67,7 @@ asset_t *asset_make_body(body_t *body) {
   body_asset_t *body_asset = malloc(sizeof(body_asset_t));
   assert(body_asset);
   SDL_Rect box = bounding_box(body);
-  body_asset->base = *asset_init(ASSET_BODY, box);
+  asset_init(&body_asset->base, ASSET_BODY, box);
   body_asset->body = body;
   return (asset_t *)body_asset;
 }
@@ -101,7 +87,7 @@ body_t *asset_get_body(asset_t *asset) {
 asset_t *asset_make_image(const char *filepath, SDL_Rect bounding_box) {
   image_asset_t *img = malloc(sizeof(image_asset_t));
   assert(img != NULL);
-  img->base = *asset_init(ASSET_IMAGE, bounding_box);
+  asset_init(&img->base, ASSET_IMAGE, bounding_box);
   img->texture =
       (SDL_Texture *)asset_cache_obj_get_or_create(ASSET_IMAGE, filepath);
   img->body = NULL;
@@ -112,7 +98,7 @@ asset_t *asset_make_image_with_body(const char *filepath, body_t *body) {
   SDL_Rect bbox = bounding_box(body);
   image_asset_t *img = malloc(sizeof(image_asset_t));
   assert(img != NULL);
-  img->base = *asset_init(ASSET_IMAGE, bbox);
+  asset_init(&img->base, ASSET_IMAGE, bbox);
   img->texture =
       (SDL_Texture *)asset_cache_obj_get_or_create(ASSET_IMAGE, filepath);
   img->body = body;
@@ -123,7 +109,7 @@ asset_t *asset_make_text(const char *filepath, SDL_Rect bounding_box,
                          const char *text, rgb_color_t color) {
   text_asset_t *text_asset = malloc(sizeof(text_asset_t));
   assert(text_asset);
-  text_asset->base = *asset_init(ASSET_FONT, bounding_box);
+  asset_init(&text_asset->base, ASSET_FONT, bounding_box);
   text_asset->font =
       (TTF_Font *)asset_cache_obj_get_or_create(ASSET_FONT, filepath);
   text_asset->text = text;
@@ -135,7 +121,7 @@ asset_t *asset_make_button(SDL_Rect bounding_box, asset_t *image_asset,
                            asset_t *text_asset, button_handler_t handler) {
   button_asset_t *button = malloc(sizeof(button_asset_t));
   assert(button);
-  button->base = *asset_init(ASSET_BUTTON, bounding_box);
+  asset_init(&button->base, ASSET_BUTTON, bounding_box);
   assert((void *)image_asset == NULL || image_asset->type == ASSET_IMAGE);
   assert((void *)text_asset == NULL || text_asset->type == ASSET_FONT);
   button->image_asset = (image_asset_t *)image_asset;
@@ -155,39 +141,65 @@ void asset_on_button_click(asset_t *button, state_t *state, double x,
   }
 }
 
+void asset_set_layer(asset_t *asset, asset_layer_t layer) {
+  asset->layer = layer;
+  if (asset->type == ASSET_BUTTON) {
+    button_asset_t *button_asset = (button_asset_t *)asset;
+    if (button_asset->image_asset != NULL) {
+      button_asset->image_asset->base.layer = layer;
+    }
+    if (button_asset->text_asset != NULL) {
+      button_asset->text_asset->base.layer = layer;
+    }
+  }
+}
+
+void asset_set_interpolation(double alpha) { render_alpha = alpha; }
+
+/**
+ * Translates a bounding box by an offset.
+ */
+static aabb_t offset_aabb(aabb_t aabb, vector_t offset) {
+  return (aabb_t){vec_add(aabb.min, offset), vec_add(aabb.max, offset)};
+}
+
 void asset_render(asset_t *asset) {
   switch (asset->type) {
   case ASSET_BODY: {
     body_asset_t *body_asset = (body_asset_t *)asset;
-    sdl_draw_polygon(body_get_polygon(body_asset->body), *body_get_color(body_asset->body));
+    vector_t offset =
+        body_get_interpolation_offset(body_asset->body, render_alpha);
+    sdl_queue_polygon_at(body_get_polygon(body_asset->body), offset,
+                         *body_get_color(body_asset->body), asset->layer);
     break;
   }
   case ASSET_IMAGE: {
     image_asset_t *image = (image_asset_t *)asset;
     if (image->body != NULL) {
       double cur_rot = body_get_rotation(image->body);
+      vector_t offset = body_get_interpolation_offset(image->body, render_alpha);
       if (cur_rot != 0) {
-        body_set_rotation(image->body, 0);
-        SDL_Rect box = bounding_box(image->body);
-        body_set_rotation(image->body, cur_rot);
+        SDL_Rect box = sdl_aabb_to_rect(
+            offset_aabb(body_get_unrotated_aabb(image->body), offset));
         vector_t body_vel = body_get_velocity(image->body);
         double rot = atan2(body_vel.y, body_vel.x);
-        sdl_draw_image_with_angle(image->texture, box, rot);
+        sdl_queue_image(image->texture, box, rot, asset->layer);
       }
       else {
-        SDL_Rect box = bounding_box(image->body);
-        sdl_draw_image(image->texture, box);
+        SDL_Rect box =
+            sdl_aabb_to_rect(offset_aabb(body_get_aabb(image->body), offset));
+        sdl_queue_image(image->texture, box, 0, asset->layer);
       }
       
     } else {
-      sdl_draw_image(image->texture, asset->bounding_box);
+      sdl_queue_image(image->texture, asset->bounding_box, 0, asset->layer);
     }
     break;
   }
   case ASSET_FONT: {
     text_asset_t *text_asset = (text_asset_t *)asset;
-    sdl_draw_text(text_asset->text, text_asset->font, text_asset->color,
-                  asset->bounding_box);
+    sdl_queue_text(text_asset->text, text_asset->font, text_asset->color,
+                   asset->bounding_box, asset->layer);
     break;
   }
   case ASSET_BUTTON: {
@@ -206,7 +218,6 @@ void asset_render(asset_t *asset) {
     break;
   }
   }
-  sdl_show();
 }
 
 void asset_set_image(asset_t *asset, const char *filepath) {
@@ -230,4 +241,15 @@ void asset_set_image(asset_t *asset, const char *filepath) {
     }
 }
 
-void asset_destroy(asset_t *asset) { free(asset); }
+void asset_destroy(asset_t *asset) {
+  if (asset->type == ASSET_BUTTON) {
+    button_asset_t *button_asset = (button_asset_t *)asset;
+    if (button_asset->image_asset != NULL) {
+      asset_destroy((asset_t *)button_asset->image_asset);
+    }
+    if (button_asset->text_asset != NULL) {
+      asset_destroy((asset_t *)button_asset->text_asset);
+    }
+  }
+  free(asset);
+}
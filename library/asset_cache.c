@@ -6,6 +6,8 @@
 #include "asset_cache.h"
 #include "list.h"
 #include "sdl_wrapper.h"
+#define ALLOC_TAG ALLOC_TAG_ASSETS
+#include "alloc.h"
 
 static list_t *ASSET_CACHE;
 
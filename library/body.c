@@ -1,45 +1,169 @@
 #include <assert.h>
+#include <stdalign.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #include "body.h"
+#include "pool.h"
+#define ALLOC_TAG ALLOC_TAG_PHYSICS
+#include "alloc.h"
+
+// most bodies have a few force jobs, which are then kept in the body itself
+enum { INLINE_FORCE_JOBS = 4 };
 
 struct body {
-  polygon_t *poly;
-  double mass;
-  vector_t force;
-  vector_t impulse;
-  bool removed;
   void *info;
   free_func_t info_freer;
+  // force jobs acting on the body: inline_force_jobs, or a separate array
+  // once there are more than fit there
+  struct force_job **force_jobs;
+  size_t num_force_jobs;
+  size_t force_jobs_capacity;
+  struct force_job *inline_force_jobs[INLINE_FORCE_JOBS];
+  // the pool the body came from, or NULL for the heap
+  pool_t *block_pool;
+  // the most vertices the polygon stored in the body can have
+  size_t capacity;
+  bool removed;
   bool rotate_with_velocity;
+  bool continuous;
+  bool has_last_acceleration;
+  body_category_t category;
+  body_type_t type;
+  // the fields read every tick come last, next to the polygon's transform
+  double mass;
+  vector_t force;
+  vector_t impulse;
+  vector_t last_displacement;
+  // the acceleration during the last tick, if ticked since the velocity was
+  // last set from outside
+  vector_t last_acceleration;
+  // the polygon stored below, unless body_set_shape() gave the body more
+  // vertices than fit there
+  polygon_t *poly;
+  // the polygon, followed by its vertices and normals
+  alignas(max_align_t) unsigned char polygon[];
 };
 
 const double INITIAL_ROTSPEED = 0;
 const double VELOCITY_AVG_FACTOR = 0.5;
+const size_t FORCE_JOBS_GROWTH_FACTOR = 2;
+const size_t INITIAL_FORCE_BUFFER_CAPACITY = 64;
+const size_t FORCE_BUFFER_GROWTH_FACTOR = 2;
+const size_t BODY_POOL_CHUNK_SIZE = 32;
+// bodies with up to 4, 8, ..., 64 vertices are pooled; larger ones are not
+const size_t MIN_POOLED_BODY_POINTS = 4;
+enum { NUM_BODY_POOLS = 5 };
 
-body_t *body_init(list_t *shape, double mass, rgb_color_t color) {
-  return body_init_with_info(shape, mass, color, NULL, NULL);
+struct body_pool {
+  // bodies by the smallest power of two at least their number of vertices
+  pool_t *bodies[NUM_BODY_POOLS];
+};
+
+/**
+ * The buffer forces added on this thread go to, or NULL to apply them
+ * directly. See body_defer_forces().
+ */
+static _Thread_local body_force_buffer_t *deferred_forces = NULL;
+
+body_t *body_init(const vector_t *shape, size_t num_points, double mass,
+                  rgb_color_t color) {
+  return body_init_with_info(shape, num_points, mass, color, NULL, NULL);
 }
 
-body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
-                            void *info, free_func_t info_freer) {
-  body_t *new = malloc(sizeof(body_t));
-  assert(new != NULL);
+/**
+ * Gets the number of bytes a body whose polygon has up to a given number of
+ * vertices takes.
+ */
+static size_t body_size(size_t capacity) {
+  return sizeof(body_t) + polygon_size(capacity);
+}
 
-  new->poly = polygon_init(shape, VEC_ZERO, INITIAL_ROTSPEED, color.r, color.g,
-                           color.b);
+body_pool_t *body_pool_init(void) {
+  body_pool_t *pool = malloc(sizeof(body_pool_t));
+  assert(pool != NULL);
+  size_t capacity = MIN_POOLED_BODY_POINTS;
+  for (size_t i = 0; i < NUM_BODY_POOLS; i++) {
+    pool->bodies[i] = pool_init(body_size(capacity), BODY_POOL_CHUNK_SIZE);
+    capacity *= 2;
+  }
+  return pool;
+}
+
+void body_pool_free(body_pool_t *pool) {
+  for (size_t i = 0; i < NUM_BODY_POOLS; i++) {
+    pool_free(pool->bodies[i]);
+  }
+  free(pool);
+}
+
+/**
+ * Whether a body's polygon is stored in the body itself.
+ */
+static bool has_inline_polygon(body_t *body) {
+  return body->poly == (polygon_t *)body->polygon;
+}
+
+/**
+ * Initializes the fields of a newly allocated body, storing its polygon in
+ * the body.
+ */
+static body_t *setup_body(body_t *new, pool_t *block_pool, size_t capacity,
+                          const vector_t *shape, size_t num_points,
+                          double mass, rgb_color_t color, void *info,
+                          free_func_t info_freer) {
+  assert(num_points <= capacity);
+  new->info = info;
+  new->info_freer = info_freer;
+  new->force_jobs = new->inline_force_jobs;
+  new->num_force_jobs = 0;
+  new->force_jobs_capacity = INLINE_FORCE_JOBS;
+  new->block_pool = block_pool;
+  new->capacity = capacity;
+  new->removed = false;
+  new->rotate_with_velocity = false;
+  new->continuous = false;
+  new->has_last_acceleration = false;
+  new->category = 0;
+  new->type = BODY_DYNAMIC;
   new->mass = mass;
   new->force = VEC_ZERO;
   new->impulse = VEC_ZERO;
-  new->removed = false;
-  new->rotate_with_velocity = false;
-  new->info = info;
-  new->info_freer = info_freer;
+  new->last_displacement = VEC_ZERO;
+  new->last_acceleration = VEC_ZERO;
+  new->poly = polygon_init_in(new->polygon, shape, num_points, VEC_ZERO,
+                              INITIAL_ROTSPEED, color.r, color.g, color.b);
   return new;
 }
 
+body_t *body_init_with_info(const vector_t *shape, size_t num_points,
+                            double mass, rgb_color_t color, void *info,
+                            free_func_t info_freer) {
+  body_t *new = malloc(body_size(num_points));
+  assert(new != NULL);
+  return setup_body(new, NULL, num_points, shape, num_points, mass, color,
+                    info, info_freer);
+}
+
+body_t *body_init_in_pool(body_pool_t *pool, const vector_t *shape,
+                          size_t num_points, double mass, rgb_color_t color,
+                          void *info, free_func_t info_freer) {
+  size_t capacity = MIN_POOLED_BODY_POINTS;
+  for (size_t i = 0; i < NUM_BODY_POOLS; i++) {
+    if (num_points <= capacity) {
+      return setup_body(pool_alloc(pool->bodies[i]), pool->bodies[i],
+                        capacity, shape, num_points, mass, color, info,
+                        info_freer);
+    }
+    capacity *= 2;
+  }
+  return body_init_with_info(shape, num_points, mass, color, info,
+                             info_freer);
+}
+
 polygon_t *body_get_polygon(body_t *body) { return body->poly; }
 
 void *body_get_info(body_t *body) { return body->info; }
@@ -48,27 +172,58 @@ void body_free(body_t *body) {
   if (body->info_freer != NULL && body->info != NULL) {
     body->info_freer(body->info);
   }
-  polygon_free(body->poly);
-  free(body);
+  if (body->force_jobs != body->inline_force_jobs) {
+    free(body->force_jobs);
+  }
+  if (!has_inline_polygon(body)) {
+    polygon_free(body->poly);
+  }
+  if (body->block_pool != NULL) {
+    pool_release(body->block_pool, body);
+  } else {
+    free(body);
+  }
 }
 
 list_t *body_get_shape(body_t *body) {
-  list_t *shape = polygon_get_points(body->poly);
-  list_t *returned = list_init(list_size(shape), free);
+  shape_view_t shape = polygon_get_view(body->poly);
+  list_t *returned = list_init(shape.size, free);
   assert(returned);
-  for (size_t i = 0; i < list_size(shape); i++) {
+  for (size_t i = 0; i < shape.size; i++) {
     vector_t *vertex = malloc(sizeof(vector_t));
     assert(vertex);
-    *vertex = *(vector_t *)list_get(shape, i);
+    *vertex = shape.points[i];
     list_add(returned, vertex);
   }
   return returned;
 }
 
+shape_view_t body_get_shape_view(body_t *body) {
+  return polygon_get_view(body->poly);
+}
+
+size_t body_num_vertices(body_t *body) {
+  return polygon_num_points(body->poly);
+}
+
+vector_t body_get_vertex(body_t *body, size_t index) {
+  return polygon_get_point(body->poly, index);
+}
+
+const vector_t *body_get_normals(body_t *body) {
+  return polygon_get_normals(body->poly);
+}
+
 vector_t body_get_centroid(body_t *body) {
   return polygon_get_center(body->poly);
 }
 
+aabb_t body_get_aabb(body_t *body) { return polygon_get_aabb(body->poly); }
+
+aabb_t body_get_unrotated_aabb(body_t *body) {
+  return polygon_get_unrotated_aabb(body->poly);
+}
+
 vector_t body_get_velocity(body_t *body) {
   vector_t *return_vector = polygon_get_velocity(body->poly);
   return *return_vector;
@@ -82,22 +237,33 @@ void body_set_color(body_t *body, rgb_color_t *col) {
   polygon_set_color(body->poly, col);
 }
 
-void body_set_shape(body_t *body, list_t *shape) {
+void body_set_shape(body_t *body, const vector_t *shape, size_t num_points) {
   polygon_t *cur_poly = body->poly;
-  vector_t *cur_vel = polygon_get_velocity(cur_poly);
-  double cur_rotation = polygon_get_rotation(cur_poly);
-  rgb_color_t *cur_color = polygon_get_color(cur_poly);
-  polygon_t *new_poly = polygon_init(shape, *cur_vel, cur_rotation, (*cur_color).r, (*cur_color).g, (*cur_color).b);
-  body->poly = new_poly;
-  polygon_free(cur_poly);
+  vector_t cur_vel = *polygon_get_velocity(cur_poly);
+  rgb_color_t cur_color = *polygon_get_color(cur_poly);
+  if (!has_inline_polygon(body)) {
+    polygon_free(cur_poly);
+  }
+  if (num_points <= body->capacity) {
+    body->poly = polygon_init_in(body->polygon, shape, num_points, cur_vel,
+                                 INITIAL_ROTSPEED, cur_color.r, cur_color.g,
+                                 cur_color.b);
+  } else {
+    // rare, so the body keeps its address and the polygon goes elsewhere
+    body->poly = polygon_init(shape, num_points, cur_vel, INITIAL_ROTSPEED,
+                              cur_color.r, cur_color.g, cur_color.b);
+  }
 }
 
 void body_set_centroid(body_t *body, vector_t x) {
   polygon_set_center(body->poly, x);
+  // a teleport is neither swept nor interpolated
+  body->last_displacement = VEC_ZERO;
 }
 
 void body_set_velocity(body_t *body, vector_t v) {
   polygon_set_velocity(body->poly, v);
+  body->has_last_acceleration = false;
 }
 
 void body_set_rotate_with_velocity(body_t *body, bool rotate_with_velocity) {
@@ -134,26 +300,83 @@ void body_tick(body_t *body, double dt) {
   vector_t new_velocity = get_new_velocity(body, dt);
   vector_t update_velocity = vec_multiply(
       VELOCITY_AVG_FACTOR, vec_add(body_get_velocity(body), new_velocity));
-  vector_t displacement = vec_multiply(dt, update_velocity);
+  body_advance(body, new_velocity, vec_multiply(dt, update_velocity));
+}
+
+void body_advance(body_t *body, vector_t new_velocity, vector_t displacement) {
   polygon_translate(body->poly, displacement);
+  body->last_displacement = displacement;
   if (body->rotate_with_velocity) {
     polygon_set_rotation(body->poly, atan2(new_velocity.y, new_velocity.x));
   }
-  body_set_velocity(body, new_velocity);
+  polygon_set_velocity(body->poly, new_velocity);
+  body->last_acceleration = vec_multiply(1.0 / body->mass, body->force);
+  body->has_last_acceleration = true;
   body->force = VEC_ZERO;
   body->impulse = VEC_ZERO;
 }
 
+void body_rewind(body_t *body, double fraction) {
+  assert(0 <= fraction && fraction <= 1);
+  polygon_translate(body->poly,
+                    vec_multiply(fraction - 1, body->last_displacement));
+  body->last_displacement = vec_multiply(fraction, body->last_displacement);
+}
+
+vector_t body_get_interpolation_offset(body_t *body, double alpha) {
+  return vec_multiply(alpha - 1, body->last_displacement);
+}
+
+vector_t body_get_last_acceleration(body_t *body) {
+  if (body->has_last_acceleration) {
+    return body->last_acceleration;
+  }
+  return vec_multiply(1.0 / body->mass, body->force);
+}
+
+vector_t body_get_force(body_t *body) { return body->force; }
+
+vector_t body_get_impulse(body_t *body) { return body->impulse; }
+
 double body_get_mass(body_t *body) { return body->mass; }
 
+/**
+ * Appends a force or impulse to the calling thread's deferred forces.
+ */
+static void defer_force(body_t *body, vector_t value, bool is_impulse) {
+  body_force_buffer_t *buffer = deferred_forces;
+  if (buffer->size == buffer->capacity) {
+    buffer->capacity = buffer->capacity == 0
+                           ? INITIAL_FORCE_BUFFER_CAPACITY
+                           : buffer->capacity * FORCE_BUFFER_GROWTH_FACTOR;
+    buffer->forces =
+        realloc(buffer->forces, buffer->capacity * sizeof(body_force_t));
+    assert(buffer->forces != NULL);
+  }
+  buffer->forces[buffer->size++] =
+      (body_force_t){.body = body, .value = value, .is_impulse = is_impulse};
+}
+
 void body_add_force(body_t *body, vector_t force) {
+  if (deferred_forces != NULL) {
+    defer_force(body, force, false);
+    return;
+  }
   body->force = vec_add(body->force, force);
 }
 
 void body_add_impulse(body_t *body, vector_t impulse) {
+  if (deferred_forces != NULL) {
+    defer_force(body, impulse, true);
+    return;
+  }
   body->impulse = vec_add(body->impulse, impulse);
 }
 
+void body_defer_forces(body_force_buffer_t *buffer) {
+  deferred_forces = buffer;
+}
+
 void body_remove(body_t *body) { body->removed = true; }
 
 bool body_is_removed(body_t *body) { return body->removed; }
@@ -161,4 +384,74 @@ bool body_is_removed(body_t *body) { return body->removed; }
 void body_reset(body_t *body) {
   body->force = VEC_ZERO;
   body->impulse = VEC_ZERO;
-}
\ No newline at end of file
+}
+
+void body_set_continuous(body_t *body, bool continuous) {
+  body->continuous = continuous;
+}
+
+bool body_is_continuous(body_t *body) { return body->continuous; }
+
+vector_t body_get_last_displacement(body_t *body) {
+  return body->last_displacement;
+}
+
+aabb_t body_get_swept_aabb(body_t *body) {
+  aabb_t aabb = polygon_get_aabb(body->poly);
+  if (body->continuous) {
+    vector_t back = vec_negate(body->last_displacement);
+    aabb.min = (vector_t){aabb.min.x + fmin(back.x, 0),
+                          aabb.min.y + fmin(back.y, 0)};
+    aabb.max = (vector_t){aabb.max.x + fmax(back.x, 0),
+                          aabb.max.y + fmax(back.y, 0)};
+  }
+  return aabb;
+}
+
+void body_set_category(body_t *body, body_category_t category) {
+  body->category = category;
+}
+
+body_category_t body_get_category(body_t *body) { return body->category; }
+
+void body_set_type(body_t *body, body_type_t type) {
+  body->type = type;
+  body_reset(body);
+  body->last_displacement = VEC_ZERO;
+}
+
+body_type_t body_get_type(body_t *body) { return body->type; }
+
+void body_add_force_job(body_t *body, struct force_job *job) {
+  if (body->num_force_jobs == body->force_jobs_capacity) {
+    size_t capacity = body->force_jobs_capacity * FORCE_JOBS_GROWTH_FACTOR;
+    struct force_job **force_jobs =
+        malloc(capacity * sizeof(struct force_job *));
+    assert(force_jobs != NULL);
+    memcpy(force_jobs, body->force_jobs,
+           body->num_force_jobs * sizeof(struct force_job *));
+    if (body->force_jobs != body->inline_force_jobs) {
+      free(body->force_jobs);
+    }
+    body->force_jobs = force_jobs;
+    body->force_jobs_capacity = capacity;
+  }
+  body->force_jobs[body->num_force_jobs++] = job;
+}
+
+void body_remove_force_jobs_if(body_t *body, list_pred_t should_remove) {
+  size_t num_kept = 0;
+  for (size_t i = 0; i < body->num_force_jobs; i++) {
+    if (!should_remove(body->force_jobs[i], NULL)) {
+      body->force_jobs[num_kept++] = body->force_jobs[i];
+    }
+  }
+  body->num_force_jobs = num_kept;
+}
+
+size_t body_num_force_jobs(body_t *body) { return body->num_force_jobs; }
+
+struct force_job *body_get_force_job(body_t *body, size_t index) {
+  assert(index < body->num_force_jobs);
+  return body->force_jobs[index];
+}
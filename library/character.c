@@ -7,6 +7,8 @@
 #include "body.h"
 #include "vector.h"
 #include "sdl_wrapper.h"
+#define ALLOC_TAG ALLOC_TAG_LEVEL
+#include "alloc.h"
 
 const vector_t CHARACTER_SIZE = {120, 120};
 const rgb_color_t WHITE = (rgb_color_t){1, 1, 1};
@@ -28,6 +30,11 @@ const double DIFFICULTY_SCALE = 2.0;
 const rgb_color_t PLATFORM_COLOR = (rgb_color_t) {0.59, 0.29, 0};
 const size_t HEALTH_BAR_ASSET_SIZE = 2;
 const double AI_SHOT_ANGLE = (45 * M_PI) / 180.0;
+// the AI flies trial shots through the wind with this time step
+const double AI_AIM_DT = 1.0 / 120;
+const double AI_AIM_MAX_TIME = 10.0;
+const size_t AI_AIM_MAX_DOUBLINGS = 8;
+const size_t AI_AIM_ITERATIONS = 30;
 
 
 struct character {
@@ -37,6 +44,7 @@ struct character {
     list_t *health_bar_assets;
     double max_health;
     double current_health;
+    double displayed_health;
     asset_t *platform_assets;
     body_t *platform_body;
     vector_t shot_start_point;
@@ -48,11 +56,14 @@ struct character {
  * 
  * @param pos position of the body
  * @param size a vector of the width and height of the body
+ * @param scene the scene whose pool the body is allocated from
  * @return a body of the specified size at the specified position
 */
-body_t *make_character_body(vector_t pos, vector_t size) {
-    list_t *shape = sdl_make_rectangle(pos.x, pos.y, size.x, size.y);
-    body_t *character = body_init(shape, INFINITY, WHITE);
+body_t *make_character_body(vector_t pos, vector_t size, scene_t *scene) {
+    vector_t shape[RECT_NUM_POINTS];
+    sdl_make_rectangle(pos.x, pos.y, size.x, size.y, shape);
+    body_t *character = body_init_in_pool(scene_get_body_pool(scene), shape, RECT_NUM_POINTS, INFINITY, WHITE, NULL, NULL);
+    body_set_type(character, BODY_KINEMATIC);
     body_set_centroid(character, vec_add(pos, vec_multiply(HALF_SIZE_SCALE_FACTOR, size)));
     return character;
 }
@@ -72,20 +83,25 @@ list_t *make_health_bar(vector_t current_pos, double max_health, scene_t *scene)
     vector_t health_bar_pos = (vector_t){current_pos.x, current_pos.y + HEALTH_BAR_Y_OFFSET};
     
     // make red health bar
-    list_t *border_shape = sdl_make_rectangle(health_bar_pos.x, health_bar_pos.y, HEALTH_BAR_SIZE.x, HEALTH_BAR_SIZE.y);
-    body_t *health_bar_border = body_init(border_shape, INFINITY, RED);
+    vector_t border_shape[RECT_NUM_POINTS];
+    sdl_make_rectangle(health_bar_pos.x, health_bar_pos.y, HEALTH_BAR_SIZE.x, HEALTH_BAR_SIZE.y, border_shape);
+    body_t *health_bar_border = body_init_in_pool(scene_get_body_pool(scene), border_shape, RECT_NUM_POINTS, INFINITY, RED, NULL, NULL);
+    body_set_type(health_bar_border, BODY_STATIC);
     body_set_centroid(health_bar_border, vec_add(health_bar_pos, vec_multiply(HALF_SIZE_SCALE_FACTOR, HEALTH_BAR_SIZE)));
     scene_add_body(scene, health_bar_border);
-    body_get_shape(health_bar_border);
     asset_t *border_asset = asset_make_body(health_bar_border);
+    asset_set_layer(border_asset, LAYER_HUD);
     list_add(health_bar_assets, border_asset);
 
     // make green health bar representing current health
-    list_t *health_shape = sdl_make_rectangle(health_bar_pos.x, health_bar_pos.y, HEALTH_BAR_SIZE.x, HEALTH_BAR_SIZE.y);
-    body_t *health_bar_health = body_init(health_shape, INFINITY, GREEN);
+    vector_t health_shape[RECT_NUM_POINTS];
+    sdl_make_rectangle(health_bar_pos.x, health_bar_pos.y, HEALTH_BAR_SIZE.x, HEALTH_BAR_SIZE.y, health_shape);
+    body_t *health_bar_health = body_init_in_pool(scene_get_body_pool(scene), health_shape, RECT_NUM_POINTS, INFINITY, GREEN, NULL, NULL);
+    body_set_type(health_bar_health, BODY_STATIC);
     body_set_centroid(health_bar_health, vec_add(health_bar_pos, vec_multiply(HALF_SIZE_SCALE_FACTOR, HEALTH_BAR_SIZE)));
     scene_add_body(scene, health_bar_health);
     asset_t *health_asset = asset_make_body(health_bar_health);
+    asset_set_layer(health_asset, LAYER_HUD);
     list_add(health_bar_assets, health_asset);
     
     return health_bar_assets;
@@ -94,10 +110,14 @@ list_t *make_health_bar(vector_t current_pos, double max_health, scene_t *scene)
 void character_update_health_bar(character_t *character) {
     asset_t *health_bar_asset = list_get(character->health_bar_assets, HEALTH_ASSET_IDX);
     body_t *health_bar = asset_get_body(health_bar_asset);
-    list_t *cur_shape = body_get_shape(health_bar);
-    vector_t *top_left = list_get(cur_shape, SHAPE_TOP_LEFT_IDX);
-    list_t *new_health_shape = sdl_make_rectangle((*top_left).x, (*top_left).y, HEALTH_BAR_SIZE.x * (character->current_health / character->max_health), HEALTH_BAR_SIZE.y);
-    body_set_shape(health_bar, new_health_shape);
+    if (character->displayed_health == character->current_health) {
+        return;
+    }
+    character->displayed_health = character->current_health;
+    vector_t top_left = body_get_vertex(health_bar, SHAPE_TOP_LEFT_IDX);
+    vector_t new_health_shape[RECT_NUM_POINTS];
+    sdl_make_rectangle(top_left.x, top_left.y, HEALTH_BAR_SIZE.x * (character->current_health / character->max_health), HEALTH_BAR_SIZE.y, new_health_shape);
+    body_set_shape(health_bar, new_health_shape, RECT_NUM_POINTS);
 }
 
 /**
@@ -109,8 +129,10 @@ void character_update_health_bar(character_t *character) {
 */
 body_t *make_platform_bar(vector_t current_pos, scene_t *scene) {
     vector_t platform_position = (vector_t){current_pos.x - PLATFORM_BAR_X_OFFSET, current_pos.y + PLATFORM_BAR_Y_OFFSET};
-    list_t *platform_shape = sdl_make_rectangle(platform_position.x, platform_position.y, PLATFORM_DIMENSIONS.x, PLATFORM_DIMENSIONS.y);
-    body_t *platform_shape_body = body_init(platform_shape, INFINITY, PLATFORM_COLOR);
+    vector_t platform_shape[RECT_NUM_POINTS];
+    sdl_make_rectangle(platform_position.x, platform_position.y, PLATFORM_DIMENSIONS.x, PLATFORM_DIMENSIONS.y, platform_shape);
+    body_t *platform_shape_body = body_init_in_pool(scene_get_body_pool(scene), platform_shape, RECT_NUM_POINTS, INFINITY, PLATFORM_COLOR, NULL, NULL);
+    body_set_type(platform_shape_body, BODY_KINEMATIC);
     return platform_shape_body;
 }
 
@@ -133,7 +155,7 @@ character_t *character_init(vector_t init_pos, double max_health, const char *im
   assert(new_character);
 
   // body
-  body_t *character = make_character_body(init_pos, CHARACTER_SIZE);
+  body_t *character = make_character_body(init_pos, CHARACTER_SIZE, scene);
   new_character->character_body = character;
   scene_add_body(scene, character);
   asset_t *character_asset = asset_make_image_with_body(img_path, character);
@@ -147,6 +169,7 @@ character_t *character_init(vector_t init_pos, double max_health, const char *im
   // health
   new_character->max_health = max_health;
   new_character->current_health = max_health;
+  new_character->displayed_health = max_health;
   list_t *health_bar_assets = make_health_bar(health_pos, max_health, scene);
   new_character->health_bar_assets = health_bar_assets;
 
@@ -226,14 +249,60 @@ vector_t character_shot_velocity(vector_t shot_start_point, vector_t shot_end_po
     return shot_velocity;
 }
 
-vector_t character_ai_shot_velocity(vector_t shot_origin, vector_t target, double difficulty, vector_t gravity) {
+/**
+ * Flies a trial shot at AI_SHOT_ANGLE through gravity and the wind until it
+ * reaches the target's x coordinate.
+ *
+ * @return how far above the target the shot passes, or -INFINITY if it
+ *   falls below the target or stops moving towards it first
+ */
+static double ai_shot_height_error(vector_t shot_origin, vector_t target, double speed, vector_t gravity, const vector_field_t *wind, double wind_time) {
+    vector_t position = shot_origin;
+    vector_t velocity = {-1.0 * speed * cos(AI_SHOT_ANGLE), speed * sin(AI_SHOT_ANGLE)};
+    for (double time = 0; time < AI_AIM_MAX_TIME; time += AI_AIM_DT) {
+        vector_t acceleration = vec_add(gravity, vector_field_at(wind, wind_time + time, position));
+        vector_t next = vec_add(position, vec_add(vec_multiply(AI_AIM_DT, velocity), vec_multiply(0.5 * AI_AIM_DT * AI_AIM_DT, acceleration)));
+        velocity = vec_add(velocity, vec_multiply(AI_AIM_DT, acceleration));
+        if (next.x <= target.x) {
+            double fraction = (position.x - target.x) / (position.x - next.x);
+            return position.y + fraction * (next.y - position.y) - target.y;
+        }
+        if (velocity.x >= 0 || (next.y < target.y && velocity.y < 0)) {
+            return -INFINITY;
+        }
+        position = next;
+    }
+    return -INFINITY;
+}
+
+vector_t character_ai_shot_velocity(vector_t shot_origin, vector_t target, double difficulty, vector_t gravity, const vector_field_t *wind, double wind_time) {
     double shot_angle = AI_SHOT_ANGLE;
     double x_diff = target.x - shot_origin.x;
     double y_diff = target.y - shot_origin.y;
     double numerator = gravity.y * x_diff * x_diff;
     double denominator = x_diff + y_diff;
     double increase_in_difficulty = (double) rand() / (double)RAND_MAX;
-    double init_vel_mag = sqrt(fabs(numerator / denominator)) + (increase_in_difficulty * DIFFICULTY_SCALE * (MAX_DIFFICULTY - difficulty));
+    double exact_vel_mag = sqrt(fabs(numerator / denominator));
+    if (wind != NULL) {
+        // the closed form ignores the wind, so bisect on the speed that
+        // flies through it to the target, starting from the closed form
+        double low = 0;
+        double high = exact_vel_mag;
+        for (size_t i = 0; i < AI_AIM_MAX_DOUBLINGS && ai_shot_height_error(shot_origin, target, high, gravity, wind, wind_time) < 0; i++) {
+            low = high;
+            high *= 2;
+        }
+        for (size_t i = 0; i < AI_AIM_ITERATIONS; i++) {
+            double middle = (low + high) / 2;
+            if (ai_shot_height_error(shot_origin, target, middle, gravity, wind, wind_time) < 0) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+        exact_vel_mag = high;
+    }
+    double init_vel_mag = exact_vel_mag + (increase_in_difficulty * DIFFICULTY_SCALE * (MAX_DIFFICULTY - difficulty));
     vector_t velocity = {-1.0 * init_vel_mag * cos(shot_angle), init_vel_mag * sin(shot_angle)}; // x coord negated so arrow goes left
     return velocity;
 }
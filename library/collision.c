@@ -5,42 +5,27 @@
 #include <math.h>
 #include <stdlib.h>
 
-/**
- * Returns a list of vectors representing the edges of a shape.
- *
- * @param shape the list of vectors representing the vertices of a shape
- * @return a list of vectors representing the edges of the shape
- */
-static list_t *get_edges(list_t *shape) {
-  list_t *edges = list_init(list_size(shape), free);
+const vector_t X_AXIS = {1, 0};
+const vector_t Y_AXIS = {0, 1};
 
-  for (size_t i = 0; i < list_size(shape); i++) {
-    vector_t *vec = malloc(sizeof(vector_t));
-    assert(vec);
-    *vec =
-        vec_subtract(*(vector_t *)list_get(shape, i % list_size(shape)),
-                     *(vector_t *)list_get(shape, (i + 1) % list_size(shape)));
-    list_add(edges, vec);
-  }
-
-  return edges;
-}
+static collision_stats_t stats = {0};
 
 /**
  * Returns a vector containing the maximum and minimum length projections given
  * a unit axis and shape.
  *
- * @param shape the list of vectors representing the vertices of a shape
+ * @param shape the vertices of a shape
  * @param unit_axis the unit axis to project eeach vertex on
  * @return a vector in the form (max, min) where `max` is the maximum projection
  * length and `min` is the minimum projection length.
  */
-static vector_t get_max_min_projections(list_t *shape, vector_t unit_axis) {
-  double max_projection = vec_dot(*(vector_t *)list_get(shape, 0), unit_axis);
+static vector_t get_max_min_projections(shape_view_t shape,
+                                        vector_t unit_axis) {
+  double max_projection = vec_dot(shape.points[0], unit_axis);
   double min_projection = max_projection;
 
-  for (size_t i = 1; i < list_size(shape); i++) {
-    double projection = vec_dot(*(vector_t *)list_get(shape, i), unit_axis);
+  for (size_t i = 1; i < shape.size; i++) {
+    double projection = vec_dot(shape.points[i], unit_axis);
     if (projection > max_projection) {
       max_projection = projection;
     } else if (projection < min_projection) {
@@ -51,25 +36,23 @@ static vector_t get_max_min_projections(list_t *shape, vector_t unit_axis) {
 }
 
 /**
- * Determines whether two convex polygons intersect.
- * The polygons are given as lists of vertices in counterclockwise order.
+ * Tests the edge normals of one convex polygon as separating axes against
+ * another. The polygons are given as vertices in counterclockwise order.
  * There is an edge between each pair of consecutive vertices,
  * and one between the first vertex and the last vertex.
  *
- * @param shape1 the first shape
- * @param shape2 the second shape
- * @return whether the shapes are colliding
+ * @param shape1 the shape whose edge normals are tested
+ * @param normals1 the unit edge normals of shape1
+ * @param shape2 the other shape
+ * @param min_overlap the smallest overlap found so far, updated in place
+ * @param axis the axis of the smallest overlap, updated in place
+ * @return false as soon as a separating axis is found, true otherwise
  */
-static collision_info_t compare_collision(list_t *shape1, list_t *shape2,
-                                          double *min_overlap) {
-  list_t *edges1 = get_edges(shape1);
-  collision_info_t compare =
-      (collision_info_t){.collided = false, .axis = VEC_ZERO};
-  for (size_t i = 0; i < list_size(edges1); i++) {
-    vector_t edge = *(vector_t *)list_get(edges1, i);
-    vector_t axis = {-edge.y, edge.x};
-    vector_t unit_axis = vec_multiply(1 / sqrt(vec_dot(axis, axis)), axis);
-
+static bool overlaps_on_axes(shape_view_t shape1, const vector_t *normals1,
+                             shape_view_t shape2, double *min_overlap,
+                             vector_t *axis) {
+  for (size_t i = 0; i < shape1.size; i++) {
+    vector_t unit_axis = normals1[i];
     vector_t max_min_projections_shape1 =
         get_max_min_projections(shape1, unit_axis);
     vector_t max_min_projections_shape2 =
@@ -78,41 +61,241 @@ static collision_info_t compare_collision(list_t *shape1, list_t *shape2,
         fmin(max_min_projections_shape1.x, max_min_projections_shape2.x) -
         fmax(max_min_projections_shape1.y, max_min_projections_shape2.y);
     if (overlap <= 0) {
-      list_free(edges1);
-      return compare;
+      return false;
     } else if (overlap < *min_overlap) {
       *min_overlap = overlap;
-      compare.axis = unit_axis;
+      *axis = unit_axis;
     }
   }
-  list_free(edges1);
-  compare.collided = true;
-  return compare;
+  return true;
 }
 
-collision_info_t find_collision(body_t *body1, body_t *body2) {
-  list_t *shape1 = body_get_shape(body1);
-  list_t *shape2 = body_get_shape(body2);
+/**
+ * Returns half the length of a box's projection onto a unit axis.
+ */
+static double box_radius(box_t box, vector_t unit_axis) {
+  return box.half_extents[0] * fabs(vec_dot(box.axes[0], unit_axis)) +
+         box.half_extents[1] * fabs(vec_dot(box.axes[1], unit_axis));
+}
+
+/**
+ * Returns the overlap of two boxes' projections onto a unit axis,
+ * which is positive if and only if the projections intersect.
+ */
+static double box_overlap(box_t box1, box_t box2, vector_t unit_axis) {
+  double center1 = vec_dot(box1.center, unit_axis);
+  double center2 = vec_dot(box2.center, unit_axis);
+  double radius1 = box_radius(box1, unit_axis);
+  double radius2 = box_radius(box2, unit_axis);
+  return fmin(center1 + radius1, center2 + radius2) -
+         fmax(center1 - radius1, center2 - radius2);
+}
+
+/**
+ * Returns whether a box's sides are parallel to the x and y axes.
+ */
+static bool box_is_axis_aligned(box_t box) {
+  return box.axes[0].x == 0 || box.axes[0].y == 0;
+}
+
+/**
+ * Builds a collision along an axis, flipped if needed to point from box1
+ * towards box2.
+ */
+static collision_info_t box_collision_info(box_t box1, box_t box2,
+                                           vector_t axis) {
+  vector_t offset = vec_subtract(box2.center, box1.center);
+  if (vec_dot(offset, axis) < 0) {
+    axis = vec_negate(axis);
+  }
+  return (collision_info_t){.collided = true, .axis = axis};
+}
+
+/**
+ * Tests two axis-aligned boxes, which only have the x and y axes to check.
+ */
+static collision_info_t aabb_collision(box_t box1, box_t box2) {
+  collision_info_t no_collision = {.collided = false, .axis = VEC_ZERO};
+  double x_overlap = box_overlap(box1, box2, X_AXIS);
+  if (x_overlap <= 0) {
+    return no_collision;
+  }
+  double y_overlap = box_overlap(box1, box2, Y_AXIS);
+  if (y_overlap <= 0) {
+    return no_collision;
+  }
+  vector_t axis = y_overlap < x_overlap ? Y_AXIS : X_AXIS;
+  return box_collision_info(box1, box2, axis);
+}
+
+/**
+ * Tests two boxes, at least one of them rotated, on the two side directions
+ * of each box.
+ */
+static collision_info_t box_collision(box_t box1, box_t box2) {
+  collision_info_t no_collision = {.collided = false, .axis = VEC_ZERO};
+  vector_t axes[] = {box1.axes[0], box1.axes[1], box2.axes[0], box2.axes[1]};
+  double min_overlap = __DBL_MAX__;
+  vector_t min_axis = VEC_ZERO;
+  for (size_t i = 0; i < sizeof(axes) / sizeof(axes[0]); i++) {
+    double overlap = box_overlap(box1, box2, axes[i]);
+    if (overlap <= 0) {
+      return no_collision;
+    } else if (overlap < min_overlap) {
+      min_overlap = overlap;
+      min_axis = axes[i];
+    }
+  }
+  return box_collision_info(box1, box2, min_axis);
+}
+
+/**
+ * Tests two convex polygons on the edge normals of both.
+ */
+static collision_info_t convex_collision(body_t *body1, body_t *body2) {
+  collision_info_t no_collision = {.collided = false, .axis = VEC_ZERO};
+  shape_view_t shape1 = body_get_shape_view(body1);
+  shape_view_t shape2 = body_get_shape_view(body2);
 
+  // the overlaps are tracked separately so that ties go to shape2's axes
   double c1_overlap = __DBL_MAX__;
   double c2_overlap = __DBL_MAX__;
+  vector_t axis1 = VEC_ZERO;
+  vector_t axis2 = VEC_ZERO;
+  if (!overlaps_on_axes(shape1, body_get_normals(body1), shape2, &c1_overlap,
+                        &axis1)) {
+    return no_collision;
+  }
+  if (!overlaps_on_axes(shape2, body_get_normals(body2), shape1, &c2_overlap,
+                        &axis2)) {
+    return no_collision;
+  }
 
-  collision_info_t collision1 = compare_collision(shape1, shape2, &c1_overlap);
-  collision_info_t collision2 = compare_collision(shape2, shape1, &c2_overlap);
+  if (c1_overlap < c2_overlap) {
+    return (collision_info_t){.collided = true, .axis = axis1};
+  }
+  return (collision_info_t){.collided = true, .axis = axis2};
+}
 
-  list_free(shape1);
-  list_free(shape2);
+/**
+ * Narrows the times at which two shapes overlap on one axis, as shape1 moves
+ * by motion relative to shape2 over the interval [0, 1].
+ *
+ * @param shape1 the moving shape, at the end of its motion
+ * @param shape2 the other shape
+ * @param motion the displacement of shape1 relative to shape2
+ * @param unit_axis the axis to project onto
+ * @param t_enter the latest time the shapes start overlapping on any axis so
+ * far, updated in place
+ * @param t_exit the earliest time they stop overlapping on any axis so far,
+ * updated in place
+ * @param axis the axis of t_enter, pointing from shape1 towards shape2
+ * @return false if the shapes never overlap on this axis
+ */
+static bool sweep_axis(shape_view_t shape1, shape_view_t shape2,
+                       vector_t motion, vector_t unit_axis, double *t_enter,
+                       double *t_exit, vector_t *axis) {
+  double speed = vec_dot(motion, unit_axis);
+  vector_t projections1 = get_max_min_projections(shape1, unit_axis);
+  vector_t projections2 = get_max_min_projections(shape2, unit_axis);
+  // shape1's projection at time 0
+  double max1 = projections1.x - speed;
+  double min1 = projections1.y - speed;
+  if (speed == 0) {
+    return max1 > projections2.y && min1 < projections2.x;
+  }
 
-  if (!collision1.collided) {
-    return collision1;
+  double touch = (projections2.y - max1) / speed;
+  double separate = (projections2.x - min1) / speed;
+  double enter = fmin(touch, separate);
+  double exit = fmax(touch, separate);
+  if (enter > *t_enter) {
+    *t_enter = enter;
+    *axis = speed > 0 ? unit_axis : vec_negate(unit_axis);
   }
+  *t_exit = fmin(*t_exit, exit);
+  return true;
+}
 
-  if (!collision2.collided) {
-    return collision2;
+/**
+ * Finds whether two bodies touched at any time during their last tick,
+ * assuming each moved in a straight line without rotating.
+ */
+static collision_info_t swept_collision(body_t *body1, body_t *body2) {
+  collision_info_t no_collision = {.collided = false, .axis = VEC_ZERO};
+  vector_t motion = vec_subtract(body_get_last_displacement(body1),
+                                 body_get_last_displacement(body2));
+  if (vec_equals(motion, VEC_ZERO)) {
+    return no_collision;
   }
 
-  if (c1_overlap < c2_overlap) {
-    return collision1;
+  // in the frame where body2 stays still, body1 ends the tick at its current
+  // offset from body2, so the current shapes can be swept back by motion
+  shape_view_t shape1 = body_get_shape_view(body1);
+  shape_view_t shape2 = body_get_shape_view(body2);
+  const vector_t *normals[] = {body_get_normals(body1),
+                               body_get_normals(body2)};
+  size_t sizes[] = {shape1.size, shape2.size};
+
+  double t_enter = -__DBL_MAX__;
+  double t_exit = __DBL_MAX__;
+  vector_t axis = VEC_ZERO;
+  for (size_t s = 0; s < 2; s++) {
+    for (size_t i = 0; i < sizes[s]; i++) {
+      if (!sweep_axis(shape1, shape2, motion, normals[s][i], &t_enter,
+                      &t_exit, &axis) ||
+          t_enter >= t_exit || t_enter > 1 || t_exit < 0) {
+        return no_collision;
+      }
+    }
   }
-  return collision2;
+  // they may already have overlapped when the tick started
+  return (collision_info_t){
+      .collided = true, .axis = axis, .time = fmax(t_enter, 0)};
 }
+
+/**
+ * Tests two bodies at their current positions, using the fastest test for
+ * their kinds of shape.
+ */
+static collision_info_t discrete_collision(body_t *body1, body_t *body2) {
+  polygon_t *poly1 = body_get_polygon(body1);
+  polygon_t *poly2 = body_get_polygon(body2);
+  if (polygon_get_kind(poly1) == POLYGON_BOX &&
+      polygon_get_kind(poly2) == POLYGON_BOX) {
+    box_t box1 = polygon_get_box(poly1);
+    box_t box2 = polygon_get_box(poly2);
+    if (box_is_axis_aligned(box1) && box_is_axis_aligned(box2)) {
+      stats.aabb_tests++;
+      return aabb_collision(box1, box2);
+    }
+    stats.box_tests++;
+    return box_collision(box1, box2);
+  }
+  stats.convex_tests++;
+  return convex_collision(body1, body2);
+}
+
+collision_info_t find_collision(body_t *body1, body_t *body2) {
+  collision_info_t info = discrete_collision(body1, body2);
+  info.time = 1;
+  if (info.collided ||
+      !(body_is_continuous(body1) || body_is_continuous(body2))) {
+    return info;
+  }
+  stats.swept_tests++;
+  return swept_collision(body1, body2);
+}
+
+void collision_move_to_contact(body_t *body1, body_t *body2,
+                               collision_info_t info) {
+  assert(info.collided);
+  if (info.time < 1) {
+    body_rewind(body1, info.time);
+    body_rewind(body2, info.time);
+  }
+}
+
+collision_stats_t collision_get_stats(void) { return stats; }
+
+void collision_reset_stats(void) { stats = (collision_stats_t){0}; }
@@ -4,6 +4,8 @@
 #include <stdlib.h>
 
 #include "color.h"
+#define ALLOC_TAG ALLOC_TAG_RENDER
+#include "alloc.h"
 
 const double COLOR_MAX = 255; // max value of each rgb value
 const double WHITE_MIX = 1;
@@ -5,17 +5,15 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#define ALLOC_TAG ALLOC_TAG_PHYSICS
+#include "alloc.h"
 
 const double MIN_DIST = 5;
 
-typedef struct body_aux {
-  double force_const;
-  list_t *bodies;
-} body_aux_t;
-
+/**
+ * The state of a force creator registered with create_collision().
+ */
 typedef struct collision_aux {
-  double force_const;
-  list_t *bodies;
   collision_handler_t handler;
   bool collided;
   void *aux; // aux (if allocated in memory) should be free'd by the caller
@@ -24,40 +22,51 @@ typedef struct collision_aux {
 typedef struct force_job {
   force_creator_t force_creator;
   void *aux;
-  list_t *bodies;
+  // frees aux, or NULL if the job does not own it
+  free_func_t aux_freer;
+  // inline_bodies, or a separate array if there are more bodies than fit
+  body_t **bodies;
+  size_t num_bodies;
+  // the bodies of jobs with few enough, so those are a single allocation
+  body_t *inline_bodies[FORCE_JOB_INLINE_BODIES];
+  // the state of the force creators in this file, which are passed the job
+  // itself as their auxiliary value
+  double force_const;
+  collision_aux_t collision;
+  bool removed;
+  bool parallel;
 } force_job_t;
 
-body_aux_t *body_aux_init(double force_const, list_t *bodies) {
-  body_aux_t *aux = malloc(sizeof(body_aux_t));
-  assert(aux);
-
-  aux->bodies = bodies;
-  aux->force_const = force_const;
-
-  return aux;
-}
-
-list_t *force_job_get_bodies(force_job_t *force_job) {
-  return ((force_job->bodies));
+/**
+ * Allocates a job for one of the force creators in this file, which reads
+ * its bodies and constant from the job.
+ */
+static force_job_t *builtin_job_init(force_creator_t force_creator,
+                                     double force_const, body_t *body1,
+                                     body_t *body2) {
+  force_job_t *job = malloc(sizeof(force_job_t));
+  assert(job);
+  *job = (force_job_t){
+      .force_creator = force_creator,
+      .aux = job,
+      .aux_freer = NULL,
+      .bodies = job->inline_bodies,
+      .num_bodies = body2 == NULL ? 1 : 2,
+      .inline_bodies = {body1, body2},
+      .force_const = force_const,
+      .removed = false,
+      .parallel = false,
+  };
+  return job;
 }
 
-collision_aux_t *collision_aux_init(double force_const, list_t *bodies,
-                                    collision_handler_t handler, bool collided,
-                                    void *aux) {
-  collision_aux_t *collision_aux = malloc(sizeof(collision_aux_t));
-  assert(collision_aux);
-
-  collision_aux->force_const = force_const;
-  collision_aux->bodies = bodies;
-  collision_aux->handler = handler;
-  collision_aux->collided = collided;
-  collision_aux->aux = aux;
-  return collision_aux;
+size_t forces_job_num_bodies(force_job_t *force_job) {
+  return force_job->num_bodies;
 }
 
-void body_aux_free(void *aux) {
-  list_free(((body_aux_t *)aux)->bodies);
-  free(aux);
+body_t *forces_job_get_body(force_job_t *force_job, size_t index) {
+  assert(index < force_job->num_bodies);
+  return force_job->bodies[index];
 }
 
 /**
@@ -65,13 +74,14 @@ void body_aux_free(void *aux) {
  * the magnitude of the force components and adds the force to each
  * associated body.
  *
- * @param info auxiliary information about the force and associated bodies
+ * @param info the force job, which holds the constant and the bodies
  */
 static void newtonian_gravity(void *info) {
-  body_aux_t *aux = (body_aux_t *)info;
+  force_job_t *job = info;
+  body_t *body1 = job->bodies[0];
+  body_t *body2 = job->bodies[1];
   vector_t displacement =
-      vec_subtract(body_get_centroid(list_get(aux->bodies, 0)),
-                   body_get_centroid(list_get(aux->bodies, 1)));
+      vec_subtract(body_get_centroid(body1), body_get_centroid(body2));
   vector_t unit_disp =
       vec_multiply(1 / sqrt(vec_dot(displacement, displacement)), displacement);
 
@@ -79,27 +89,20 @@ static void newtonian_gravity(void *info) {
 
   if (distance > MIN_DIST) {
     vector_t grav_force = vec_multiply(
-        aux->force_const * body_get_mass(list_get(aux->bodies, 0)) *
-            body_get_mass(list_get(aux->bodies, 1)) /
+        job->force_const * body_get_mass(body1) * body_get_mass(body2) /
             vec_dot(displacement, displacement),
         unit_disp);
 
-    body_add_force(list_get(aux->bodies, 1), grav_force);
-    body_add_force(list_get(aux->bodies, 0), vec_multiply(-1, grav_force));
+    body_add_force(body2, grav_force);
+    body_add_force(body1, vec_multiply(-1, grav_force));
   }
 }
 
 void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
                               body_t *body2) {
-  list_t *bodies = list_init(2, NULL);
-  list_t *aux_bodies = list_init(2, NULL);
-  list_add(bodies, body1);
-  list_add(bodies, body2);
-  list_add(aux_bodies, body1);
-  list_add(aux_bodies, body2);
-  body_aux_t *aux = body_aux_init(G, aux_bodies);
-  scene_add_bodies_force_creator(scene, (force_creator_t)newtonian_gravity, aux,
-                                 bodies);
+  force_job_t *job = builtin_job_init(newtonian_gravity, G, body1, body2);
+  job->parallel = true;
+  scene_add_force_job(scene, job);
 }
 
 /**
@@ -107,14 +110,14 @@ void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
  * the magnitude of the force components and adds the force to each
  * associated body.
  *
- * @param info auxiliary information about the force and associated bodies
+ * @param info the force job, which holds the constant and the bodies
  */
 static void spring_force(void *info) {
-  body_aux_t *aux = info;
+  force_job_t *job = info;
 
-  double k = aux->force_const;
-  body_t *body1 = list_get(aux->bodies, 0);
-  body_t *body2 = list_get(aux->bodies, 1);
+  double k = job->force_const;
+  body_t *body1 = job->bodies[0];
+  body_t *body2 = job->bodies[1];
 
   vector_t center_1 = body_get_centroid(body1);
   vector_t center_2 = body_get_centroid(body2);
@@ -126,15 +129,9 @@ static void spring_force(void *info) {
 }
 
 void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2) {
-  list_t *bodies = list_init(2, NULL);
-  list_add(bodies, body1);
-  list_add(bodies, body2);
-  list_t *aux_bodies = list_init(2, NULL);
-  list_add(aux_bodies, body1);
-  list_add(aux_bodies, body2);
-  body_aux_t *aux = body_aux_init(k, aux_bodies);
-  scene_add_bodies_force_creator(scene, (force_creator_t)spring_force, aux,
-                                 bodies);
+  force_job_t *job = builtin_job_init(spring_force, k, body1, body2);
+  job->parallel = true;
+  scene_add_force_job(scene, job);
 }
 
 /**
@@ -142,38 +139,35 @@ void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2) {
  * the magnitude of the force components and adds the force to the
  * associated body.
  *
- * @param info auxiliary information about the force and associated body
+ * @param info the force job, which holds the constant and the body
  */
 static void drag_force(void *info) {
-  body_aux_t *aux = (body_aux_t *)info;
-  vector_t cons_force = vec_multiply(
-      -1 * aux->force_const, body_get_velocity(list_get(aux->bodies, 0)));
+  force_job_t *job = info;
+  body_t *body = job->bodies[0];
+  vector_t cons_force =
+      vec_multiply(-1 * job->force_const, body_get_velocity(body));
 
-  body_add_force(list_get(aux->bodies, 0), cons_force);
+  body_add_force(body, cons_force);
 }
 
 void create_drag(scene_t *scene, double gamma, body_t *body) {
-  list_t *bodies = list_init(1, NULL);
-  list_t *aux_bodies = list_init(1, NULL);
-  list_add(bodies, body);
-  list_add(aux_bodies, body);
-  body_aux_t *aux = body_aux_init(gamma, aux_bodies);
-  scene_add_bodies_force_creator(scene, (force_creator_t)drag_force, aux,
-                                 bodies);
+  force_job_t *job = builtin_job_init(drag_force, gamma, body, NULL);
+  job->parallel = true;
+  scene_add_force_job(scene, job);
 }
 
 /**
  * The force creator for collisions. Checks if the bodies in the collision aux
  * are colliding, and if they do, runs the collision handler on the bodies.
  *
- * @param info auxiliary information about the force and associated body
+ * @param force_job the force job, which holds the handler and the bodies
  */
-static void collision_force_creator(void *collision_aux) {
-  collision_aux_t *col_aux = collision_aux;
+static void collision_force_creator(void *force_job) {
+  force_job_t *job = force_job;
+  collision_aux_t *col_aux = &job->collision;
 
-  list_t *bodies = col_aux->bodies;
-  body_t *body1 = list_get(bodies, 0);
-  body_t *body2 = list_get(bodies, 1);
+  body_t *body1 = job->bodies[0];
+  body_t *body2 = job->bodies[1];
 
   // Check for collision; if bodies collide, call collision_handler
   bool prev_collision = col_aux->collided;
@@ -183,7 +177,8 @@ static void collision_force_creator(void *collision_aux) {
   if (info.collided && !prev_collision) {
     collision_handler_t handler = col_aux->handler;
 
-    handler(body1, body2, info.axis, col_aux->aux, col_aux->force_const);
+    collision_move_to_contact(body1, body2, info);
+    handler(body1, body2, info.axis, col_aux->aux, job->force_const);
     col_aux->collided = true;
   } else if (!info.collided && prev_collision) {
     col_aux->collided = false;
@@ -193,19 +188,14 @@ static void collision_force_creator(void *collision_aux) {
 void create_collision(scene_t *scene, body_t *body1, body_t *body2,
                       collision_handler_t handler, void *aux,
                       double force_const) {
-  list_t *bodies = list_init(2, NULL);
-  list_add(bodies, body1);
-  list_add(bodies, body2);
-
-  list_t *aux_bodies = list_init(2, NULL);
-  list_add(aux_bodies, body1);
-  list_add(aux_bodies, body2);
-
-  collision_aux_t *collision_aux =
-      collision_aux_init(force_const, aux_bodies, handler, false, aux);
-
-  scene_add_bodies_force_creator(scene, collision_force_creator, collision_aux,
-                                 bodies);
+  force_job_t *job =
+      builtin_job_init(collision_force_creator, force_const, body1, body2);
+  job->collision = (collision_aux_t){
+      .handler = handler,
+      .collided = false,
+      .aux = aux,
+  };
+  scene_add_force_job(scene, job);
 }
 
 /**
@@ -256,20 +246,54 @@ void create_physics_collision(scene_t *scene, body_t *body1, body_t *body2,
 }
 
 force_job_t *forces_job_init(force_creator_t force_creator, void *aux,
-                             list_t *bodies) {
+                             list_t *bodies, free_func_t aux_freer) {
+  size_t num_bodies = list_size(bodies);
   force_job_t *new = malloc(sizeof(force_job_t));
   assert(new);
-  new->force_creator = force_creator;
-  new->aux = aux;
-  new->bodies = bodies;
+  body_t **body_array = new->inline_bodies;
+  if (num_bodies > FORCE_JOB_INLINE_BODIES) {
+    body_array = malloc(num_bodies * sizeof(body_t *));
+    assert(body_array);
+  }
+  *new = (force_job_t){
+      .force_creator = force_creator,
+      .aux = aux,
+      .aux_freer = aux_freer,
+      .bodies = body_array,
+      .num_bodies = num_bodies,
+      .removed = false,
+      .parallel = false,
+  };
+  for (size_t i = 0; i < num_bodies; i++) {
+    new->bodies[i] = list_get(bodies, i);
+  }
   return new;
 }
 
+void forces_job_set_parallel(force_job_t *force_job, bool parallel) {
+  force_job->parallel = parallel;
+}
+
+bool forces_job_is_parallel(force_job_t *force_job) {
+  return force_job->parallel;
+}
+
+void forces_job_remove(force_job_t *force_job) { force_job->removed = true; }
+
+bool forces_job_is_removed(force_job_t *force_job) {
+  return force_job->removed;
+}
+
 void forces_job_run(force_job_t *force_job) {
   force_job->force_creator(force_job->aux);
 }
 
 void forces_job_free(force_job_t *force_job) {
-  body_aux_free(force_job->aux);
+  if (force_job->aux_freer != NULL) {
+    force_job->aux_freer(force_job->aux);
+  }
+  if (force_job->bodies != force_job->inline_bodies) {
+    free(force_job->bodies);
+  }
   free(force_job);
 };
@@ -0,0 +1,371 @@
+#include "gravity_field.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#define ALLOC_TAG ALLOC_TAG_PHYSICS
+#include "alloc.h"
+
+// the same cutoff as create_newtonian_gravity()
+const double GRAVITY_FIELD_MIN_DIST = 5;
+// below this many bodies, summing every pair is faster than building a tree
+const size_t GRAVITY_FIELD_EXACT_MAX_BODIES = 64;
+const size_t GRAVITY_FIELD_INITIAL_CAPACITY = 16;
+const size_t GRAVITY_FIELD_GROWTH_FACTOR = 2;
+const size_t NO_INDEX = SIZE_MAX;
+// the half width of the root cell when every body is at the same point
+const double MIN_ROOT_HALF_WIDTH = 1;
+
+enum {
+  QUADTREE_CHILDREN = 4,
+  // bodies closer than the root width / 2^32 share a leaf instead of
+  // splitting it forever
+  QUADTREE_MAX_DEPTH = 32,
+  QUADTREE_STACK_SIZE = QUADTREE_CHILDREN * (QUADTREE_MAX_DEPTH + 1),
+};
+
+/**
+ * A body in the field, with its state gathered at the start of a tick.
+ */
+typedef struct field_body {
+  body_handle_t handle;
+  body_t *body;
+  vector_t position;
+  double mass;
+  /** The sum of mass / distance^2 over the bodies pulling on this one */
+  vector_t pull;
+  /** The next body in the same leaf, or NO_INDEX */
+  size_t next;
+} field_body_t;
+
+/**
+ * A square cell of the quadtree.
+ */
+typedef struct quad_node {
+  vector_t center;
+  double half_width;
+  double mass;
+  /** The sum of mass * position over the bodies in the cell */
+  vector_t moment;
+  /** The index of the first of the four children, or NO_INDEX for a leaf */
+  size_t first_child;
+  /** The first body in a leaf, or NO_INDEX */
+  size_t first_body;
+} quad_node_t;
+
+struct gravity_field {
+  scene_t *scene;
+  double G;
+  double opening_angle;
+  field_body_t *bodies;
+  size_t num_bodies;
+  size_t body_capacity;
+  // rebuilt every tick; kept to avoid reallocating it
+  quad_node_t *nodes;
+  size_t num_nodes;
+  size_t node_capacity;
+};
+
+/**
+ * Grows an array geometrically so it can hold at least `needed` elements.
+ * See the function of the same name in scene.c.
+ */
+static void *reserve(void *array, size_t *capacity, size_t needed,
+                     size_t elem_size) {
+  if (needed <= *capacity) {
+    return array;
+  }
+  size_t new_capacity = *capacity == 0
+                            ? GRAVITY_FIELD_INITIAL_CAPACITY
+                            : *capacity * GRAVITY_FIELD_GROWTH_FACTOR;
+  while (new_capacity < needed) {
+    new_capacity *= GRAVITY_FIELD_GROWTH_FACTOR;
+  }
+  array = realloc(array, new_capacity * elem_size);
+  assert(array != NULL);
+  *capacity = new_capacity;
+  return array;
+}
+
+static void gravity_field_free(void *field) {
+  gravity_field_t *gravity_field = field;
+  free(gravity_field->bodies);
+  free(gravity_field->nodes);
+  free(gravity_field);
+}
+
+/**
+ * Drops the bodies that have left the scene and reads the positions and
+ * masses of the rest.
+ */
+static void gather_bodies(gravity_field_t *field) {
+  size_t num_bodies = 0;
+  for (size_t i = 0; i < field->num_bodies; i++) {
+    body_handle_t handle = field->bodies[i].handle;
+    body_t *body = scene_get_body_by_handle(field->scene, handle);
+    if (body == NULL || body_is_removed(body)) {
+      continue;
+    }
+    field->bodies[num_bodies++] = (field_body_t){
+        .handle = handle,
+        .body = body,
+        .position = body_get_centroid(body),
+        .mass = body_get_mass(body),
+        .pull = VEC_ZERO,
+        .next = NO_INDEX,
+    };
+  }
+  field->num_bodies = num_bodies;
+}
+
+/**
+ * The pull of a point mass on a point, or 0 if they are too close.
+ */
+static vector_t pull_towards(vector_t position, vector_t source, double mass) {
+  vector_t displacement = vec_subtract(source, position);
+  double distance_squared = vec_dot(displacement, displacement);
+  if (distance_squared <= GRAVITY_FIELD_MIN_DIST * GRAVITY_FIELD_MIN_DIST) {
+    return VEC_ZERO;
+  }
+  double distance = sqrt(distance_squared);
+  return vec_multiply(mass / (distance_squared * distance), displacement);
+}
+
+/**
+ * Sums the pull of every body on every other body.
+ */
+static void pull_exact(field_body_t *bodies, size_t num_bodies) {
+  for (size_t i = 0; i < num_bodies; i++) {
+    for (size_t j = i + 1; j < num_bodies; j++) {
+      vector_t toward_j =
+          pull_towards(bodies[i].position, bodies[j].position, 1);
+      bodies[i].pull =
+          vec_add(bodies[i].pull, vec_multiply(bodies[j].mass, toward_j));
+      bodies[j].pull =
+          vec_subtract(bodies[j].pull, vec_multiply(bodies[i].mass, toward_j));
+    }
+  }
+}
+
+static size_t add_node(gravity_field_t *field, vector_t center,
+                       double half_width) {
+  field->nodes = reserve(field->nodes, &field->node_capacity,
+                         field->num_nodes + 1, sizeof(quad_node_t));
+  field->nodes[field->num_nodes] = (quad_node_t){
+      .center = center,
+      .half_width = half_width,
+      .mass = 0,
+      .moment = VEC_ZERO,
+      .first_child = NO_INDEX,
+      .first_body = NO_INDEX,
+  };
+  return field->num_nodes++;
+}
+
+static size_t quadrant(quad_node_t *node, vector_t position) {
+  return (position.x >= node->center.x ? 1 : 0) +
+         (position.y >= node->center.y ? 2 : 0);
+}
+
+/**
+ * Turns a leaf into an internal node with four empty children.
+ * May move the node array, so indices must be used across calls.
+ */
+static void split(gravity_field_t *field, size_t node) {
+  vector_t center = field->nodes[node].center;
+  double quarter_width = field->nodes[node].half_width / 2;
+  size_t first_child = field->num_nodes;
+  for (size_t i = 0; i < QUADTREE_CHILDREN; i++) {
+    vector_t offset = {(i & 1) ? quarter_width : -quarter_width,
+                       (i & 2) ? quarter_width : -quarter_width};
+    add_node(field, vec_add(center, offset), quarter_width);
+  }
+  field->nodes[node].first_child = first_child;
+}
+
+static void add_to_cell(quad_node_t *node, field_body_t *body) {
+  node->mass += body->mass;
+  node->moment =
+      vec_add(node->moment, vec_multiply(body->mass, body->position));
+}
+
+static void insert(gravity_field_t *field, size_t index) {
+  field_body_t *body = &field->bodies[index];
+  size_t node = 0;
+  for (size_t depth = 0;; depth++) {
+    add_to_cell(&field->nodes[node], body);
+    if (field->nodes[node].first_child == NO_INDEX) {
+      size_t resident = field->nodes[node].first_body;
+      if (resident == NO_INDEX || depth == QUADTREE_MAX_DEPTH) {
+        body->next = resident;
+        field->nodes[node].first_body = index;
+        return;
+      }
+      // a leaf holds one body, so move its body down a level
+      split(field, node);
+      field->nodes[node].first_body = NO_INDEX;
+      field_body_t *moved = &field->bodies[resident];
+      quad_node_t *child = &field->nodes[field->nodes[node].first_child +
+                                         quadrant(&field->nodes[node],
+                                                  moved->position)];
+      add_to_cell(child, moved);
+      child->first_body = resident;
+    }
+    quad_node_t *parent = &field->nodes[node];
+    node = parent->first_child + quadrant(parent, body->position);
+  }
+}
+
+static void build_tree(gravity_field_t *field) {
+  vector_t min = field->bodies[0].position;
+  vector_t max = min;
+  for (size_t i = 1; i < field->num_bodies; i++) {
+    vector_t position = field->bodies[i].position;
+    min = (vector_t){fmin(min.x, position.x), fmin(min.y, position.y)};
+    max = (vector_t){fmax(max.x, position.x), fmax(max.y, position.y)};
+  }
+  double half_width = fmax(fmax(max.x - min.x, max.y - min.y) / 2,
+                           MIN_ROOT_HALF_WIDTH);
+  field->num_nodes = 0;
+  add_node(field, vec_multiply(0.5, vec_add(min, max)), half_width);
+  for (size_t i = 0; i < field->num_bodies; i++) {
+    insert(field, i);
+  }
+}
+
+/**
+ * Sums the pull on one body, walking down the tree until each cell is either
+ * small enough for its distance to be treated as a point mass or a leaf.
+ */
+static vector_t pull_from_tree(gravity_field_t *field, size_t index) {
+  vector_t position = field->bodies[index].position;
+  vector_t pull = VEC_ZERO;
+  size_t stack[QUADTREE_STACK_SIZE];
+  size_t stack_size = 0;
+  stack[stack_size++] = 0;
+  while (stack_size > 0) {
+    quad_node_t *node = &field->nodes[stack[--stack_size]];
+    if (node->mass == 0) {
+      continue;
+    }
+    if (node->first_child == NO_INDEX) {
+      for (size_t i = node->first_body; i != NO_INDEX;
+           i = field->bodies[i].next) {
+        if (i != index) {
+          field_body_t *other = &field->bodies[i];
+          pull = vec_add(pull,
+                         pull_towards(position, other->position, other->mass));
+        }
+      }
+      continue;
+    }
+    vector_t center_of_mass = vec_multiply(1 / node->mass, node->moment);
+    double distance = vec_get_length(vec_subtract(center_of_mass, position));
+    if (2 * node->half_width < field->opening_angle * distance) {
+      pull = vec_add(pull, pull_towards(position, center_of_mass, node->mass));
+      continue;
+    }
+    assert(stack_size + QUADTREE_CHILDREN <= QUADTREE_STACK_SIZE);
+    for (size_t i = 0; i < QUADTREE_CHILDREN; i++) {
+      stack[stack_size++] = node->first_child + i;
+    }
+  }
+  return pull;
+}
+
+/**
+ * Fills in the pull on every gathered body, exactly for few bodies and with
+ * Barnes-Hut otherwise.
+ */
+static void compute_pulls(gravity_field_t *field) {
+  if (field->num_bodies <= GRAVITY_FIELD_EXACT_MAX_BODIES) {
+    pull_exact(field->bodies, field->num_bodies);
+    return;
+  }
+  build_tree(field);
+  for (size_t i = 0; i < field->num_bodies; i++) {
+    field->bodies[i].pull = pull_from_tree(field, i);
+  }
+}
+
+/**
+ * The force creator for a gravity field.
+ */
+static void gravity_field_force(void *aux) {
+  gravity_field_t *field = aux;
+  gather_bodies(field);
+  compute_pulls(field);
+  for (size_t i = 0; i < field->num_bodies; i++) {
+    field_body_t *body = &field->bodies[i];
+    body_add_force(body->body,
+                   vec_multiply(field->G * body->mass, body->pull));
+  }
+}
+
+gravity_field_t *create_gravity_field(scene_t *scene, double G,
+                                      double opening_angle) {
+  assert(opening_angle >= 0);
+  gravity_field_t *field = malloc(sizeof(gravity_field_t));
+  assert(field != NULL);
+  *field = (gravity_field_t){
+      .scene = scene,
+      .G = G,
+      .opening_angle = opening_angle,
+      .bodies = NULL,
+      .num_bodies = 0,
+      .body_capacity = 0,
+      .nodes = NULL,
+      .num_nodes = 0,
+      .node_capacity = 0,
+  };
+  // registered without bodies, so removing a body does not remove the field
+  scene_add_parallel_force_creator(scene, gravity_field_force, field,
+                                   list_init(0, NULL), gravity_field_free);
+  return field;
+}
+
+void gravity_field_add_body(gravity_field_t *field, body_handle_t body) {
+  field->bodies = reserve(field->bodies, &field->body_capacity,
+                          field->num_bodies + 1, sizeof(field_body_t));
+  field->bodies[field->num_bodies++] = (field_body_t){.handle = body};
+}
+
+void gravity_field_set_opening_angle(gravity_field_t *field,
+                                     double opening_angle) {
+  assert(opening_angle >= 0);
+  field->opening_angle = opening_angle;
+}
+
+size_t gravity_field_num_bodies(gravity_field_t *field) {
+  gather_bodies(field);
+  return field->num_bodies;
+}
+
+double gravity_field_measure_error(gravity_field_t *field) {
+  gather_bodies(field);
+  size_t num_bodies = field->num_bodies;
+  if (num_bodies == 0) {
+    return 0;
+  }
+  field_body_t *exact = malloc(num_bodies * sizeof(field_body_t));
+  assert(exact != NULL);
+  for (size_t i = 0; i < num_bodies; i++) {
+    exact[i] = field->bodies[i];
+  }
+  pull_exact(exact, num_bodies);
+  compute_pulls(field);
+
+  double error_squared = 0;
+  double exact_squared = 0;
+  for (size_t i = 0; i < num_bodies; i++) {
+    double mass = field->bodies[i].mass;
+    vector_t force = vec_multiply(mass, field->bodies[i].pull);
+    vector_t exact_force = vec_multiply(mass, exact[i].pull);
+    vector_t error = vec_subtract(force, exact_force);
+    error_squared += vec_dot(error, error);
+    exact_squared += vec_dot(exact_force, exact_force);
+  }
+  free(exact);
+  return exact_squared == 0 ? 0 : sqrt(error_squared / exact_squared);
+}
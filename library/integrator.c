@@ -0,0 +1,162 @@
+#include "integrator.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+// fusing a multiply and add would round differently from body_tick()
+#pragma STDC FP_CONTRACT OFF
+
+const double INTEGRATOR_AVG_FACTOR = 0.5;
+const double INTEGRATOR_HALF = 0.5;
+
+/**
+ * Integrates one body along the axis with INTEGRATOR_AVERAGE_VELOCITY.
+ * Every vector path below performs the same operations in the same order,
+ * so all paths round identically.
+ */
+static void average_one(integrator_axis_t axis, size_t i, double dt) {
+  double velocity = axis.velocity[i];
+  double inv_mass = axis.inv_mass[i];
+  double change = inv_mass * axis.impulse[i] + dt * (inv_mass * axis.force[i]);
+  double new_velocity = velocity + change;
+  axis.displacement[i] =
+      dt * (INTEGRATOR_AVG_FACTOR * (velocity + new_velocity));
+  axis.velocity[i] = new_velocity;
+}
+
+#if defined(__AVX__)
+
+enum { INTEGRATOR_LANES = 4 };
+
+static void average_lanes(integrator_axis_t axis, size_t i, double dt) {
+  __m256d dts = _mm256_set1_pd(dt);
+  __m256d velocity = _mm256_loadu_pd(&axis.velocity[i]);
+  __m256d inv_mass = _mm256_loadu_pd(&axis.inv_mass[i]);
+  __m256d change = _mm256_add_pd(
+      _mm256_mul_pd(inv_mass, _mm256_loadu_pd(&axis.impulse[i])),
+      _mm256_mul_pd(dts,
+                    _mm256_mul_pd(inv_mass, _mm256_loadu_pd(&axis.force[i]))));
+  __m256d new_velocity = _mm256_add_pd(velocity, change);
+  __m256d average = _mm256_mul_pd(_mm256_set1_pd(INTEGRATOR_AVG_FACTOR),
+                                  _mm256_add_pd(velocity, new_velocity));
+  _mm256_storeu_pd(&axis.displacement[i], _mm256_mul_pd(dts, average));
+  _mm256_storeu_pd(&axis.velocity[i], new_velocity);
+}
+
+#elif defined(__SSE2__)
+
+enum { INTEGRATOR_LANES = 2 };
+
+static void average_lanes(integrator_axis_t axis, size_t i, double dt) {
+  __m128d dts = _mm_set1_pd(dt);
+  __m128d velocity = _mm_loadu_pd(&axis.velocity[i]);
+  __m128d inv_mass = _mm_loadu_pd(&axis.inv_mass[i]);
+  __m128d change = _mm_add_pd(
+      _mm_mul_pd(inv_mass, _mm_loadu_pd(&axis.impulse[i])),
+      _mm_mul_pd(dts, _mm_mul_pd(inv_mass, _mm_loadu_pd(&axis.force[i]))));
+  __m128d new_velocity = _mm_add_pd(velocity, change);
+  __m128d average = _mm_mul_pd(_mm_set1_pd(INTEGRATOR_AVG_FACTOR),
+                               _mm_add_pd(velocity, new_velocity));
+  _mm_storeu_pd(&axis.displacement[i], _mm_mul_pd(dts, average));
+  _mm_storeu_pd(&axis.velocity[i], new_velocity);
+}
+
+#elif defined(__wasm_simd128__)
+
+enum { INTEGRATOR_LANES = 2 };
+
+static void average_lanes(integrator_axis_t axis, size_t i, double dt) {
+  v128_t dts = wasm_f64x2_splat(dt);
+  v128_t velocity = wasm_v128_load(&axis.velocity[i]);
+  v128_t inv_mass = wasm_v128_load(&axis.inv_mass[i]);
+  v128_t change = wasm_f64x2_add(
+      wasm_f64x2_mul(inv_mass, wasm_v128_load(&axis.impulse[i])),
+      wasm_f64x2_mul(dts,
+                     wasm_f64x2_mul(inv_mass, wasm_v128_load(&axis.force[i]))));
+  v128_t new_velocity = wasm_f64x2_add(velocity, change);
+  v128_t average = wasm_f64x2_mul(wasm_f64x2_splat(INTEGRATOR_AVG_FACTOR),
+                                  wasm_f64x2_add(velocity, new_velocity));
+  wasm_v128_store(&axis.displacement[i], wasm_f64x2_mul(dts, average));
+  wasm_v128_store(&axis.velocity[i], new_velocity);
+}
+
+#else
+
+enum { INTEGRATOR_LANES = 1 };
+
+static void average_lanes(integrator_axis_t axis, size_t i, double dt) {
+  average_one(axis, i, dt);
+}
+
+#endif
+
+static void average_velocity(integrator_axis_t axis, size_t size, double dt) {
+  size_t i = 0;
+  for (; i + INTEGRATOR_LANES <= size; i += INTEGRATOR_LANES) {
+    average_lanes(axis, i, dt);
+  }
+  for (; i < size; i++) {
+    average_one(axis, i, dt);
+  }
+}
+
+static void semi_implicit_euler(integrator_axis_t axis, size_t size,
+                                double dt) {
+  for (size_t i = 0; i < size; i++) {
+    double inv_mass = axis.inv_mass[i];
+    double new_velocity = axis.velocity[i] + inv_mass * axis.impulse[i] +
+                          dt * (inv_mass * axis.force[i]);
+    axis.displacement[i] = dt * new_velocity;
+    axis.velocity[i] = new_velocity;
+  }
+}
+
+static void velocity_verlet(integrator_axis_t axis, size_t size, double dt) {
+  for (size_t i = 0; i < size; i++) {
+    double inv_mass = axis.inv_mass[i];
+    double acceleration = inv_mass * axis.force[i];
+    // the last tick assumed its acceleration would last; correct that to
+    // the average of its acceleration and this tick's
+    double velocity =
+        axis.velocity[i] + inv_mass * axis.impulse[i] +
+        INTEGRATOR_HALF * dt * (acceleration - axis.last_acceleration[i]);
+    axis.displacement[i] =
+        dt * velocity + INTEGRATOR_HALF * dt * dt * acceleration;
+    axis.velocity[i] = velocity + dt * acceleration;
+  }
+}
+
+static void constant_acceleration(integrator_axis_t axis, size_t size,
+                                  double dt) {
+  for (size_t i = 0; i < size; i++) {
+    double inv_mass = axis.inv_mass[i];
+    double acceleration = inv_mass * axis.force[i];
+    double velocity = axis.velocity[i] + inv_mass * axis.impulse[i];
+    axis.displacement[i] =
+        dt * velocity + INTEGRATOR_HALF * dt * dt * acceleration;
+    axis.velocity[i] = velocity + dt * acceleration;
+  }
+}
+
+void integrator_step(integrator_t integrator, integrator_axis_t axis,
+                     size_t size, double dt) {
+  switch (integrator) {
+  case INTEGRATOR_AVERAGE_VELOCITY:
+    average_velocity(axis, size, dt);
+    break;
+  case INTEGRATOR_SEMI_IMPLICIT_EULER:
+    semi_implicit_euler(axis, size, dt);
+    break;
+  case INTEGRATOR_VELOCITY_VERLET:
+    velocity_verlet(axis, size, dt);
+    break;
+  case INTEGRATOR_CONSTANT_ACCELERATION:
+    constant_acceleration(axis, size, dt);
+    break;
+  }
+}
@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <math.h>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
@@ -13,21 +14,29 @@
 #include "asset_cache.h"
 #include "color.h"
 #include "sdl_wrapper.h"
+#define ALLOC_TAG ALLOC_TAG_LEVEL
+#include "alloc.h"
 
 // Level
 const vector_t SCREEN_MIN = {0, 0};
 const vector_t SCREEN_MAX = {1000, 500};
 const size_t ASSET_MEMORY = 12;
-const ssize_t LEFT_WALL_X = -999;
-const size_t RIGHT_WALL_X_OFFSET = 2;
-const size_t WALL_HEIGHT_FACTOR = 3;
-const size_t WALL_WIDTH_LEFT = 1001;
-const size_t WALL_WIDTH_RIGHT = 1000;
-const size_t GROUND_Y = 2;
-const size_t GROUND_HEIGHT = 1000;
+// World bounds, inset from the edges of the screen
+const vector_t LEFT_WALL_NORMAL = {1, 0};
+const vector_t RIGHT_WALL_NORMAL = {-1, 0};
+const vector_t GROUND_NORMAL = {0, 1};
+const double BOUND_INSET = 2;
+
+// Physics runs at a fixed rate, independent of the frame rate
+const double PHYSICS_DT = 1.0 / 240;
+// Longer frames are clamped so a stall cannot snowball into ever more steps
+// or fire the AI's shot early
+const double MAX_FRAME_TIME = 0.25;
 
 // Bullet
 const size_t BULLET_MEMORY = 10;
+// arrows built when a level starts; more are built if all of them are flying
+const size_t NUM_PREBUILT_BULLETS = 4;
 const char *BULLET_PATH = "assets/arrow.png";
 const double BULLET_MASS = 10;
 const double BULLET_WIDTH = 50;
@@ -88,13 +97,28 @@ const double CHARACTER_MAX_HEALTH = 5000.0;
 const double BOTTOM_BUFFER = 100;
 const double BUFFER = 85;
 
+// Collision categories
+const body_category_t CATEGORY_PLAYER_ONE = 1 << 0;
+const body_category_t CATEGORY_PLAYER_TWO = 1 << 1;
+const body_category_t CATEGORY_BULLET_FROM_ONE = 1 << 2;
+const body_category_t CATEGORY_BULLET_FROM_TWO = 1 << 3;
+
+/**
+ * An arrow, kept in the scene for the whole level and recycled. An arrow that
+ * is not in flight is parked: uncategorized, static and not drawn, so the
+ * scene neither moves nor collides it. Firing it just resets its state, so it
+ * costs no allocations and no collision setup.
+ */
+typedef struct bullet {
+  body_t *body;
+  asset_t *asset;
+  bool in_flight;
+} bullet_t;
+
 typedef struct level {
     list_t *assets;
     character_t *character_one;
     character_t *character_two;
-    body_t *left_wall;
-    body_t *right_wall;
-    body_t *ground;
     scene_t *scene;
     list_t *bullets;
     list_t *helper_dots;
@@ -106,6 +130,8 @@ typedef struct level {
     vector_t char_platform_velocity;
     list_t *game_over_assets;
     vector_t gravity;
+    // frame time not yet simulated, less than PHYSICS_DT after each frame
+    double physics_time;
 } level_t;
 
 typedef struct start_screen {
@@ -261,6 +287,7 @@ start_screen_t *start_screen_init() {
   // background
   SDL_Rect bounding_box = sdl_get_bounds(SCREEN_MAX.y, SCREEN_MAX.x, VEC_ZERO.x, VEC_ZERO.y);
   new->background = asset_make_image(START_SCREEN_PATH, bounding_box);
+  asset_set_layer(new->background, LAYER_BACKGROUND);
 
   // buttons
   TTF_Init();
@@ -282,6 +309,7 @@ skin_screen_t *skin_screen_init() {
   // background
   SDL_Rect bounding_box = sdl_get_bounds(SCREEN_MAX.y, SCREEN_MAX.x, VEC_ZERO.x, VEC_ZERO.y);
   new->background = asset_make_image(SKIN_SCREEN_PATH, bounding_box);
+  asset_set_layer(new->background, LAYER_BACKGROUND);
 
   // buttons
   TTF_Init();
@@ -310,6 +338,7 @@ void skin_screen_main(skin_screen_t *screen) {
 void skin_screen_free(skin_screen_t *screen) {
   list_free(screen->buttons);
   asset_destroy(screen->background);
+  asset_destroy(screen->skin_display);
   free(screen);
 }
 
@@ -326,14 +355,30 @@ void start_screen_free(start_screen_t *screen) {
   free(screen);
 }
 
+void bullet_collision_handler(body_t *body1, body_t *body2, vector_t axis,
+                              void *aux, double force_const);
+
+static bullet_t *add_bullet(level_t *level);
+
+/**
+ * Frees a bullet and its asset. The body is freed by the scene.
+ *
+ * @param bullet the bullet to free
+ */
+static void bullet_free(bullet_t *bullet) {
+  asset_destroy(bullet->asset);
+  free(bullet);
+}
+
 level_t *level_init(level_info_t level_info) {
   level_t *new = malloc(sizeof(level_t));
   assert(new);
 
   new->scene = scene_init();
   new->assets = list_init(ASSET_MEMORY, (free_func_t)asset_destroy);
-  new->bullets = list_init(BULLET_MEMORY, (free_func_t)body_free);
-  new->helper_dots = list_init(NUM_HELPER_DOTS * HELPER_DOT_COLORS, (free_func_t)body_free);
+  new->bullets = list_init(BULLET_MEMORY, (free_func_t)bullet_free);
+  // the scene owns the dots' bodies
+  new->helper_dots = list_init(NUM_HELPER_DOTS * HELPER_DOT_COLORS, NULL);
   new->screen_name = level_info.screen_name;
   new->use_ai = level_info.use_ai;
   new->char_platform_velocity = level_info.character_2_velocity;
@@ -341,24 +386,19 @@ level_t *level_init(level_info_t level_info) {
   new->ai_difficulty = level_info.ai_difficulty;
   new->turn = true;
   new->gravity = level_info.level_gravity;
+  scene_set_vector_field(new->scene, level_info.wind);
+  new->physics_time = 0;
 
   // background
   SDL_Rect bounding_box1 = sdl_get_bounds(SCREEN_MAX.y, SCREEN_MAX.x, VEC_ZERO.x, VEC_ZERO.y);
   asset_t *background_asset = asset_make_image(level_info.background_image_path, bounding_box1);
+  asset_set_layer(background_asset, LAYER_BACKGROUND);
   list_add(new->assets, background_asset);
 
-  // walls
-  new->left_wall = body_init(sdl_make_rectangle(LEFT_WALL_X, SCREEN_MAX.y * WALL_HEIGHT_FACTOR, WALL_WIDTH_LEFT, SCREEN_MAX.y * WALL_HEIGHT_FACTOR), INFINITY, BLACK);
-  list_add(new->assets, asset_make_body(new->left_wall));
-  new->right_wall = body_init(sdl_make_rectangle(SCREEN_MAX.x - RIGHT_WALL_X_OFFSET, SCREEN_MAX.y * WALL_HEIGHT_FACTOR, WALL_WIDTH_RIGHT, SCREEN_MAX.y * WALL_HEIGHT_FACTOR), INFINITY, BLACK);
-  list_add(new->assets, asset_make_body(new->right_wall));
-  scene_add_body(new->scene, new->right_wall);
-  new->ground = body_init(sdl_make_rectangle(0, GROUND_Y, SCREEN_MAX.x, GROUND_HEIGHT), INFINITY, BLACK);
-  list_add(new->assets, asset_make_body(new->ground));
-
   // first character
   character_t *character = character_init(level_info.inital_character_one_pos, level_info.character_one_max_health, level_info.character_one_image_path, new->scene, CHARACTER_ONE_HEALTH_POSITION);
   new->character_one = character;
+  body_set_category(character_get_body(character), CATEGORY_PLAYER_ONE);
   list_add(new->assets, character_get_body_asset(character)); 
   list_add(new->assets, character_get_platform_asset(character));
   list_t *character_health_bar_assets = character_get_health_bar_assets(character);
@@ -368,6 +408,7 @@ level_t *level_init(level_info_t level_info) {
   // second character
   character_t *character_two = character_init(level_info.inital_character_two_pos, level_info.character_two_max_health, level_info.character_two_image_path, new->scene, CHARACTER_TWO_HEALTH_POSITION);
   new->character_two = character_two;
+  body_set_category(character_get_body(character_two), CATEGORY_PLAYER_TWO);
   character_set_velocity(new->character_two, new->char_platform_velocity);
   character_set_platform_velocity(new->character_two, new->char_platform_velocity);
   list_add(new->assets, character_get_body_asset(character_two));
@@ -385,32 +426,42 @@ level_t *level_init(level_info_t level_info) {
     asset_t *text_asset = asset_make_text(game_over_buttons[i].font_path, game_over_buttons[i].image_box, game_over_buttons[i].text, game_over_buttons[i].text_color);
     list_add(new->game_over_assets, asset_make_button(game_over_buttons[i].image_box, image_asset, text_asset, game_over_buttons[i].handler));
   }
+  for (size_t i = 0; i < list_size(new->game_over_assets); i++) {
+    asset_set_layer(list_get(new->game_over_assets, i), LAYER_OVERLAY);
+  }
+
+  // bullets hit the opposing player, the walls and the ground
+  body_category_t bullets = CATEGORY_BULLET_FROM_ONE | CATEGORY_BULLET_FROM_TWO;
+  scene_add_category_collision(new->scene, CATEGORY_BULLET_FROM_ONE, CATEGORY_PLAYER_TWO, bullet_collision_handler, new, BULLET_ELASTICITY);
+  scene_add_category_collision(new->scene, CATEGORY_BULLET_FROM_TWO, CATEGORY_PLAYER_ONE, bullet_collision_handler, new, BULLET_ELASTICITY);
+  scene_add_bound(new->scene, LEFT_WALL_NORMAL, SCREEN_MIN.x + BOUND_INSET, bullets, bullet_collision_handler, new, BULLET_ELASTICITY);
+  scene_add_bound(new->scene, RIGHT_WALL_NORMAL, -(SCREEN_MAX.x - BOUND_INSET), bullets, bullet_collision_handler, new, BULLET_ELASTICITY);
+  scene_add_bound(new->scene, GROUND_NORMAL, SCREEN_MIN.y + BOUND_INSET, bullets, bullet_collision_handler, new, BULLET_ELASTICITY);
+  for (size_t i = 0; i < NUM_PREBUILT_BULLETS; i++) {
+    add_bullet(new);
+  }
   return new;
 }
 
 /** Make a circle-shaped body object.
  *
+ * @param scene the scene whose pool the body is allocated from
  * @param center a vector representing the center of the body.
  * @param radius the radius of the circle
  * @param mass the mass of the body
  * @param color the color of the circle
  * @return pointer to the circle-shaped body
  */
-body_t *make_circle(vector_t center, double radius, double mass,
-                    rgb_color_t color) {
-  list_t *c = list_init(CIRC_NPOINTS, free);
+body_t *make_circle(scene_t *scene, vector_t center, double radius,
+                    double mass, rgb_color_t color) {
+  vector_t c[CIRC_NPOINTS];
   for (size_t i = 0; i < CIRC_NPOINTS; i++) {
     double angle = 2 * M_PI * i / CIRC_NPOINTS;
-
-    vector_t *v = malloc(sizeof(*v));
-    assert(v);
-
     vector_t unit = {cos(angle), sin(angle)};
-    *v = vec_add(vec_multiply(radius, unit), center);
-
-    list_add(c, v);
+    c[i] = vec_add(vec_multiply(radius, unit), center);
   }
-  return body_init(c, mass, color);
+  return body_init_in_pool(scene_get_body_pool(scene), c, CIRC_NPOINTS, mass,
+                           color, NULL, NULL);
 }
 
 /**
@@ -455,8 +506,10 @@ void level_set_shot_start(level_t *level, double x, double y) {
 
   // Creating black dot border
   for (size_t i = 0; i < NUM_HELPER_DOTS; i++) {
-    body_t *dot = make_circle(dots_start_point, DOT_RADIUS * 2, INFINITY, BLACK);
+    body_t *dot = make_circle(level->scene, dots_start_point, DOT_RADIUS * 2, INFINITY, BLACK);
+    body_set_type(dot, BODY_STATIC);
     asset_t *dot_asset = asset_make_body(dot);
+    asset_set_layer(dot_asset, LAYER_HUD);
     list_add(level->helper_dots, dot);
     list_add(level->assets, dot_asset);
     scene_add_body(level->scene, dot);
@@ -464,8 +517,10 @@ void level_set_shot_start(level_t *level, double x, double y) {
 
   // Creating white dots inside
   for (size_t i = 0; i < NUM_HELPER_DOTS; i++) {
-    body_t *dot = make_circle(dots_start_point, DOT_RADIUS, INFINITY, WHITE_DOT_COLOR);
+    body_t *dot = make_circle(level->scene, dots_start_point, DOT_RADIUS, INFINITY, WHITE_DOT_COLOR);
+    body_set_type(dot, BODY_STATIC);
     asset_t *dot_asset = asset_make_body(dot);
+    asset_set_layer(dot_asset, LAYER_HUD);
     list_add(level->helper_dots, dot);
     list_add(level->assets, dot_asset);
     scene_add_body(level->scene, dot);
@@ -518,12 +573,24 @@ void level_cycle_turns(level_t *level) {
   level->turn = !level->turn;
 }
 
+/**
+ * Takes an arrow out of flight until it is fired again.
+ *
+ * @param bullet the arrow to park
+ */
+static void park_bullet(bullet_t *bullet) {
+  body_set_category(bullet->body, 0);
+  body_set_type(bullet->body, BODY_STATIC);
+  body_set_velocity(bullet->body, VEC_ZERO);
+  bullet->in_flight = false;
+}
+
 /**
  * The collision handler for collisions between bullets and objects.
  * If hitting a character, lowers health proportional to the incoming velocity.
  *
  * @param body1 the body for the bullet
- * @param body2 the body of the other object
+ * @param body2 the body of the other object, or NULL for the walls and ground
  * @param axis the axis of collision
  * @param aux the game state
  * @param elasticity the elasticity of the collision
@@ -541,66 +608,81 @@ void bullet_collision_handler(body_t *body1, body_t *body2, vector_t axis,
     sdl_play_sound_effect(HIT);
     character_deduct_health(level->character_two, damage);
   }
-  body_remove(body1);
+  park_bullet(body_get_info(body1));
   if (level->use_ai && !level->turn && !level_game_over(level)) {
     level_start_ai_countdown(level, 1.5);
   }
+}
+
+bool level_bullet_in_scene(level_t *level) {
   for (size_t i = 0; i < list_size(level->bullets); i++) {
-    if (list_get(level->bullets, i) == body1) {
-      list_remove(level->bullets, i);
-    }
-  }
-  for (size_t i = 0; i < list_size(level->assets); i++) {
-    if (asset_get_body(list_get(level->assets, i)) == body1) {
-      list_remove(level->assets, i);
+    if (((bullet_t *)list_get(level->bullets, i))->in_flight) {
+      return true;
     }
   }
+  return false;
 }
 
-bool level_bullet_in_scene(level_t *level) {
-  return list_size(level->bullets) > 0;
+/**
+ * Builds a parked arrow, adds it to the level's scene and to its arrows.
+ *
+ * @param level the level to add the arrow to
+ * @return the new arrow
+ */
+static bullet_t *add_bullet(level_t *level) {
+  bullet_t *new = malloc(sizeof(bullet_t));
+  assert(new != NULL);
+  vector_t bullet_shape[RECT_NUM_POINTS];
+  sdl_make_rectangle(0, 0, BULLET_WIDTH, BULLET_HEIGHT, bullet_shape);
+  new->body = body_init_in_pool(scene_get_body_pool(level->scene),
+                                bullet_shape, RECT_NUM_POINTS, BULLET_MASS,
+                                BLACK, new, NULL);
+  body_set_rotate_with_velocity(new->body, true);
+  body_set_continuous(new->body, true);
+  new->asset = asset_make_image_with_body(BULLET_PATH, new->body);
+  scene_add_body(level->scene, new->body);
+  park_bullet(new);
+  list_add(level->bullets, new);
+  return new;
 }
 
 /**
- * Makes the bullet the bullet body for the character.
+ * Fires a parked arrow from the front of a character, building another arrow
+ * only if every arrow is already in flight.
  *
- * @param level game level used to calculate center for the bullet
- * @param character character that is shooting the bullet
- * @param mass mass of the bullet
- * @param color color of the bullet
- * @return body of the bullet
+ * @param level the level the character is in
+ * @param character the character that is shooting
+ * @param velocity the initial velocity of the arrow
  */
+static void fire_bullet(level_t *level, character_t *character,
+                        vector_t velocity) {
+  bullet_t *bullet = NULL;
+  for (size_t i = 0; i < list_size(level->bullets) && bullet == NULL; i++) {
+    bullet_t *candidate = list_get(level->bullets, i);
+    if (!candidate->in_flight) {
+      bullet = candidate;
+    }
+  }
+  if (bullet == NULL) {
+    bullet = add_bullet(level);
+  }
 
-body_t *make_bullet(level_t *level, character_t *character, double mass,
-                    rgb_color_t color) {
-  vector_t bullet_center; 
+  // the arrow's top left corner starts at the front of the character
   vector_t character_center = body_get_centroid(character_get_body(character));
   double character_half_width = character_get_size(level->character_one).x * HALF_SCALE_FACTOR;
+  vector_t corner = (vector_t){character_center.x - character_half_width, character_center.y};
+  body_category_t category = CATEGORY_BULLET_FROM_TWO;
   if (character == level->character_one) {
-    bullet_center = (vector_t){character_center.x + character_half_width, character_center.y};
+    corner.x = character_center.x + character_half_width;
+    category = CATEGORY_BULLET_FROM_ONE;
   }
-  else {
-    bullet_center = (vector_t){character_center.x - character_half_width, character_center.y};
-  }
-  list_t *bullet_shape = sdl_make_rectangle(bullet_center.x, bullet_center.y, BULLET_WIDTH, BULLET_HEIGHT);
-  body_t *bullet = body_init(bullet_shape, mass, color);
-  body_set_rotate_with_velocity(bullet, true);
-  return bullet;
-}
-
-/**
- * Creates collisions between the bullet and the player that is being target,
- * the left and right walls, and the ground.
- * 
- * @param level pointer to the current level
- * @param bullet pointer to the body of the bullet
- * @param character_to_hit pointer to the body of the character that should be affected by this bullet
-*/
-void create_bullet_collision(level_t *level, body_t *bullet, body_t *character_to_hit) {
-  create_collision(level->scene, bullet, character_to_hit, bullet_collision_handler, level, BULLET_ELASTICITY);
-  create_collision(level->scene, bullet, level->left_wall, bullet_collision_handler, level, BULLET_ELASTICITY);
-  create_collision(level->scene, bullet, level->right_wall, bullet_collision_handler, level, BULLET_ELASTICITY);
-  create_collision(level->scene, bullet, level->ground, bullet_collision_handler, level, BULLET_ELASTICITY);
+  body_t *body = bullet->body;
+  body_set_rotation(body, 0);
+  body_set_centroid(body, (vector_t){corner.x + BULLET_WIDTH * HALF_SCALE_FACTOR, corner.y - BULLET_HEIGHT * HALF_SCALE_FACTOR});
+  body_set_type(body, BODY_DYNAMIC);
+  body_set_velocity(body, velocity);
+  body_set_category(body, category);
+  bullet->in_flight = true;
 }
 
 void level_ai_shoot(level_t *level) {
@@ -614,14 +696,8 @@ void level_ai_shoot(level_t *level) {
   vector_t shot_origin = (vector_t){ai_center.x - ai_half_width, ai_center.y};
   
   // make bullet
-  vector_t init_velocity = character_ai_shot_velocity(shot_origin, player_center, level->ai_difficulty, level->gravity);
-  body_t *bullet = make_bullet(level, level->character_two, BULLET_MASS, BLACK);
-  body_set_velocity(bullet, init_velocity);
-  create_bullet_collision(level, bullet, character_get_body(level->character_one));
-  asset_t *bullet_asset = asset_make_image_with_body(BULLET_PATH, bullet);
-  scene_add_body(level->scene, bullet);
-  list_add(level->assets, bullet_asset);
-  list_add(level->bullets, bullet);
+  vector_t init_velocity = character_ai_shot_velocity(shot_origin, player_center, level->ai_difficulty, level->gravity, scene_get_vector_field(level->scene), scene_get_time(level->scene));
+  fire_bullet(level, level->character_two, init_velocity);
 
   sdl_play_sound_effect(SHOOT);
   level_cycle_turns(level);
@@ -640,7 +716,6 @@ double level_update_ai_countdown(level_t *level, double dt) {
 
 void level_shoot_shot(level_t *level, double x, double y) {
   character_t *character = get_character_turn(level, false);
-  character_t *character_opposite = get_character_turn(level, true);
   vector_t shot_end_point = (vector_t){x, y};
   vector_t shot_start_point = character_get_shot_start_point(character);
   if (!vec_equals(shot_start_point, VEC_ZERO)) {
@@ -649,19 +724,13 @@ void level_shoot_shot(level_t *level, double x, double y) {
     for (size_t i = 0; i < HELPER_DOT_COLORS * NUM_HELPER_DOTS; i++) {
       body_t* body_to_remove = list_remove(level->helper_dots, 0);
       body_remove(body_to_remove);
-      list_remove(level->assets, list_size(level->assets) - 1);
+      asset_destroy(list_remove(level->assets, list_size(level->assets) - 1));
     }
 
     // make bullet
     character_set_shot_end_point(character, shot_end_point);
     vector_t init_velocity = character_shot_velocity(shot_start_point, shot_end_point, SHOT_MAX_SPEED);
-    body_t *bullet = make_bullet(level, character, BULLET_MASS, BLACK);
-    asset_t *bullet_asset = asset_make_image_with_body(BULLET_PATH, bullet);
-    body_set_velocity(bullet, init_velocity);
-    create_bullet_collision(level, bullet, character_get_body(character_opposite));
-    scene_add_body(level->scene, bullet);
-    list_add(level->assets, bullet_asset);
-    list_add(level->bullets, bullet);
+    fire_bullet(level, character, init_velocity);
 
     // reset shot parameters
     character_set_shot_start_point(character, VEC_ZERO);
@@ -704,14 +773,27 @@ ssize_t level_get_skin_button_index_clicked(double x, double y) {
   return index;
 }
 
+void level_enter(level_t *level) {
+  // restart the clock so time spent in menus and other levels is not
+  // simulated on the first frame
+  time_since_last_tick();
+  level->physics_time = 0;
+}
+
 void level_main(level_t *level) {
-  double dt = time_since_last_tick();
+  double dt = fmin(time_since_last_tick(), MAX_FRAME_TIME);
 
-  // rendering assets
-  sdl_render_scene(level->scene, NULL);
+  // rendering assets, between the last two physics states
+  asset_set_interpolation(level->physics_time / PHYSICS_DT);
   for (size_t i = 0; i < list_size(level->assets); i++) {
     asset_render(list_get(level->assets, i));
   }
+  for (size_t i = 0; i < list_size(level->bullets); i++) {
+    bullet_t *bullet = list_get(level->bullets, i);
+    if (bullet->in_flight) {
+      asset_render(bullet->asset);
+    }
+  }
 
   // moving platform
   if (character_position_limit(level->character_two, SCREEN_MIN.y + BOTTOM_BUFFER, SCREEN_MAX.y - BUFFER)) {
@@ -728,16 +810,24 @@ void level_main(level_t *level) {
   // update shots
   character_update_health_bar(level->character_one);
   character_update_health_bar(level->character_two);
-  for (size_t i = 0; i < list_size(level->bullets); i++) {
-    body_t *bullet = list_get(level->bullets, i);
-    body_add_force(bullet, vec_multiply(body_get_mass(bullet), level->gravity));
-  }
   level_update_helper_dots(level);
   if (level_update_ai_countdown(level, dt) <= 0) {
     level_ai_shoot(level);
     level->ai_countdown = INFINITY;
   }
-  scene_tick(level->scene, dt);
+
+  // step the physics at a fixed rate, carrying the remainder to next frame
+  level->physics_time += dt;
+  while (level->physics_time >= PHYSICS_DT) {
+    for (size_t i = 0; i < list_size(level->bullets); i++) {
+      bullet_t *bullet = list_get(level->bullets, i);
+      if (bullet->in_flight) {
+        body_add_force(bullet->body, vec_multiply(body_get_mass(bullet->body), level->gravity));
+      }
+    }
+    scene_tick(level->scene, PHYSICS_DT);
+    level->physics_time -= PHYSICS_DT;
+  }
 }
 
 bool level_game_over(level_t *level) {
@@ -780,11 +870,46 @@ double level_get_character2_health(level_t *level) {
   return character_get_health(level->character_two);
 }
 
+/**
+ * Takes an asset out of a list without freeing it.
+ *
+ * @param assets the list to remove the asset from
+ * @param asset the asset to remove, if it is in the list
+ */
+static void forget_asset(list_t *assets, asset_t *asset) {
+  for (size_t i = 0; i < list_size(assets); i++) {
+    if (list_get(assets, i) == asset) {
+      list_remove(assets, i);
+      return;
+    }
+  }
+}
+
+/**
+ * Takes the assets a character owns out of the level's assets, so that only
+ * character_free() frees them.
+ *
+ * @param level the level the character is in
+ * @param character the character whose assets to remove
+ */
+static void forget_character_assets(level_t *level, character_t *character) {
+  forget_asset(level->assets, character_get_body_asset(character));
+  forget_asset(level->assets, character_get_platform_asset(character));
+  list_t *health_bar_assets = character_get_health_bar_assets(character);
+  for (size_t i = 0; i < list_size(health_bar_assets); i++) {
+    forget_asset(level->assets, list_get(health_bar_assets, i));
+  }
+}
+
 void level_free(level_t *level) {
+  forget_character_assets(level, level->character_one);
+  forget_character_assets(level, level->character_two);
   character_free(level->character_one);
   character_free(level->character_two);
   list_free(level->bullets);
   list_free(level->assets);
+  list_free(level->helper_dots);
+  list_free(level->game_over_assets);
   scene_free(level->scene);
   free(level);
 }
@@ -1,6 +1,8 @@
 #include "list.h"
 #include <assert.h>
 #include <stdlib.h>
+#define ALLOC_TAG ALLOC_TAG_CORE
+#include "alloc.h"
 
 size_t const CAPACITY_FACTOR = 2;
 
@@ -73,3 +75,21 @@ void *list_remove(list_t *list, size_t index) {
   list->size--;
   return removed;
 }
+
+size_t list_remove_if(list_t *list, list_pred_t should_remove, void *aux) {
+  assert(list != NULL);
+  size_t kept = 0;
+  for (size_t i = 0; i < list->size; i++) {
+    void *value = list->data[i];
+    if (should_remove(value, aux)) {
+      if (list->freer != NULL) {
+        list->freer(value);
+      }
+    } else {
+      list->data[kept++] = value;
+    }
+  }
+  size_t removed = list->size - kept;
+  list->size = kept;
+  return removed;
+}
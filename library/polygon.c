@@ -1,43 +1,295 @@
 #include "polygon.h"
 #include "color.h"
-#include "list.h"
 #include "vector.h"
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
+#define ALLOC_TAG ALLOC_TAG_PHYSICS
+#include "alloc.h"
 
+/**
+ * A polygon is stored as an immutable shape in local space, centered on its
+ * centroid, plus a transform (a position and a rotation). World-space vertices
+ * are only produced when they are read, so moving or rotating a polygon is
+ * O(1) and repeated rotations cannot accumulate rounding error in the shape.
+ */
 typedef struct polygon {
-  list_t *points;
   vector_t velocity;
   double rotation_speed;
-  rgb_color_t *color;
+  rgb_color_t color;
+  // world position of the centroid
+  vector_t position;
   double rotation;
+  double cos_rotation;
+  double sin_rotation;
+  double area;
+  // bounding box of the unrotated local shape
+  aabb_t local_aabb;
+  // cached world-space bounding box, valid unless aabb_dirty is set
+  aabb_t aabb;
+  bool aabb_dirty;
+  // cached world-space vertices, valid unless world_dirty is set
+  vector_t *world;
+  bool world_dirty;
+  // unit edge normals in local space, and rotated into world space
+  vector_t *local_normals;
+  vector_t *world_normals;
+  bool normals_dirty;
+  polygon_kind_t kind;
+  // for boxes, the unit side vectors in local space and half their lengths
+  vector_t box_axes[BOX_NUM_AXES];
+  double box_half_extents[BOX_NUM_AXES];
+  size_t num_points;
+  // num_points each of local vertices, world vertices, local normals and
+  // world normals
+  vector_t local[];
 } polygon_t;
 
 size_t const CENTROID_SCALE = 6;
 double const INITIAL_ROTANG = 0;
+size_t const BOX_NUM_POINTS = 4;
+// relative tolerance when deciding whether a quadrilateral is a rectangle
+double const BOX_TOLERANCE = 1e-9;
 
-polygon_t *polygon_init(list_t *points, vector_t initial_velocity,
-                        double rotation_speed, double red, double green,
-                        double blue) {
-  polygon_t *polygon = malloc(sizeof(polygon_t));
+/**
+ * Computes the area of a polygon from its vertices with the shoelace formula.
+ */
+static double compute_area(const vector_t *points, size_t size) {
+  double area = 0;
+  if (size < 3)
+    return area;
+
+  // shoelace formula
+  vector_t prev = points[size - 1];
+  for (size_t i = 0; i < size; i++) {
+    vector_t current = points[i];
+    area += vec_cross(prev, current);
+    prev = current;
+  }
+  return 0.5 * fabs(area);
+}
+
+/**
+ * Computes the centroid of a polygon from its vertices.
+ */
+static vector_t compute_centroid(const vector_t *points, size_t size) {
+  double signed_area = 0;
+  vector_t centroid = {0, 0};
+
+  // signed area using shoelace formula
+  vector_t prev = points[size - 1];
+  for (size_t i = 0; i < size; i++) {
+    vector_t current = points[i];
+    double cross_prod = vec_cross(prev, current);
+    signed_area += cross_prod;
+    centroid.x += (current.x + prev.x) * cross_prod;
+    centroid.y += (current.y + prev.y) * cross_prod;
+    prev = current;
+  }
+
+  signed_area *= 0.5;
+  centroid.x /= CENTROID_SCALE * signed_area;
+  centroid.y /= CENTROID_SCALE * signed_area;
+  return centroid;
+}
+
+/**
+ * Computes the axis-aligned bounding box of a set of vertices.
+ */
+static aabb_t compute_aabb(const vector_t *points, size_t size) {
+  aabb_t aabb = {.min = points[0], .max = points[0]};
+  for (size_t i = 1; i < size; i++) {
+    vector_t p = points[i];
+    aabb.min.x = fmin(aabb.min.x, p.x);
+    aabb.min.y = fmin(aabb.min.y, p.y);
+    aabb.max.x = fmax(aabb.max.x, p.x);
+    aabb.max.y = fmax(aabb.max.y, p.y);
+  }
+  return aabb;
+}
+
+/**
+ * Marks the cached world-space data as stale after the transform changes.
+ */
+static void invalidate(polygon_t *polygon, bool rotated) {
+  polygon->world_dirty = true;
+  if (rotated) {
+    polygon->aabb_dirty = true;
+    polygon->normals_dirty = true;
+  }
+}
+
+/**
+ * Computes the unit normal of the edge from each vertex to the next.
+ */
+static void compute_normals(const vector_t *points, size_t size,
+                            vector_t *normals) {
+  for (size_t i = 0; i < size; i++) {
+    vector_t edge = vec_subtract(points[i], points[(i + 1) % size]);
+    vector_t axis = {-edge.y, edge.x};
+    normals[i] = vec_multiply(1 / sqrt(vec_dot(axis, axis)), axis);
+  }
+}
+
+/**
+ * Detects whether the polygon is a rectangle, and if so, records its sides.
+ */
+static void classify_shape(polygon_t *polygon) {
+  polygon->kind = POLYGON_CONVEX;
+  if (polygon->num_points != BOX_NUM_POINTS) {
+    return;
+  }
+
+  const vector_t *p = polygon->local;
+  vector_t side0 = vec_subtract(p[1], p[0]);
+  vector_t side1 = vec_subtract(p[2], p[1]);
+  vector_t side2 = vec_subtract(p[3], p[2]);
+  vector_t side3 = vec_subtract(p[0], p[3]);
+  double len0 = sqrt(vec_dot(side0, side0));
+  double len1 = sqrt(vec_dot(side1, side1));
+  double tolerance = BOX_TOLERANCE * fmax(len0, len1);
+  // a rectangle has perpendicular adjacent sides and equal opposite ones
+  vector_t diff0 = vec_add(side0, side2);
+  vector_t diff1 = vec_add(side1, side3);
+  if (len0 == 0 || len1 == 0 ||
+      fabs(vec_dot(side0, side1)) > BOX_TOLERANCE * len0 * len1 ||
+      sqrt(vec_dot(diff0, diff0)) > tolerance ||
+      sqrt(vec_dot(diff1, diff1)) > tolerance) {
+    return;
+  }
+
+  polygon->kind = POLYGON_BOX;
+  polygon->box_axes[0] = vec_multiply(1 / len0, side0);
+  polygon->box_axes[1] = vec_multiply(1 / len1, side1);
+  polygon->box_half_extents[0] = 0.5 * len0;
+  polygon->box_half_extents[1] = 0.5 * len1;
+}
+
+/**
+ * Recomputes the world-space vertices from the local shape and the transform,
+ * if they are stale.
+ */
+static void update_world(polygon_t *polygon) {
+  if (!polygon->world_dirty) {
+    return;
+  }
+  double c = polygon->cos_rotation;
+  double s = polygon->sin_rotation;
+  for (size_t i = 0; i < polygon->num_points; i++) {
+    vector_t p = polygon->local[i];
+    polygon->world[i] = (vector_t){polygon->position.x + p.x * c - p.y * s,
+                                   polygon->position.y + p.x * s + p.y * c};
+  }
+  polygon->world_dirty = false;
+}
+
+/**
+ * Rotates the local edge normals into world space, if they are stale.
+ */
+static void update_normals(polygon_t *polygon) {
+  if (!polygon->normals_dirty) {
+    return;
+  }
+  double c = polygon->cos_rotation;
+  double s = polygon->sin_rotation;
+  for (size_t i = 0; i < polygon->num_points; i++) {
+    vector_t n = polygon->local_normals[i];
+    polygon->world_normals[i] =
+        (vector_t){n.x * c - n.y * s, n.x * s + n.y * c};
+  }
+  polygon->normals_dirty = false;
+}
+
+/**
+ * Sets the rotation of the transform and its cached sine and cosine.
+ */
+static void set_transform_rotation(polygon_t *polygon, double rot) {
+  polygon->rotation = rot;
+  polygon->cos_rotation = cos(rot);
+  polygon->sin_rotation = sin(rot);
+}
+
+size_t polygon_size(size_t num_points) {
+  return sizeof(polygon_t) + 4 * num_points * sizeof(vector_t);
+}
+
+polygon_t *polygon_init(const vector_t *points, size_t num_points,
+                        vector_t initial_velocity, double rotation_speed,
+                        double red, double green, double blue) {
+  polygon_t *polygon = malloc(polygon_size(num_points));
   assert(polygon != NULL);
-  polygon->points = points;
+  return polygon_init_in(polygon, points, num_points, initial_velocity,
+                         rotation_speed, red, green, blue);
+}
+
+polygon_t *polygon_init_in(void *memory, const vector_t *points,
+                           size_t num_points, vector_t initial_velocity,
+                           double rotation_speed, double red, double green,
+                           double blue) {
+  polygon_t *polygon = memory;
+  vector_t centroid = compute_centroid(points, num_points);
+  for (size_t i = 0; i < num_points; i++) {
+    polygon->local[i] = vec_subtract(points[i], centroid);
+  }
+  polygon->world = polygon->local + num_points;
+  polygon->local_normals = polygon->world + num_points;
+  polygon->world_normals = polygon->local_normals + num_points;
+  compute_normals(polygon->local, num_points, polygon->local_normals);
+  polygon->num_points = num_points;
+  classify_shape(polygon);
   polygon->velocity = initial_velocity;
   polygon->rotation_speed = rotation_speed;
-  polygon->color = color_init(red, green, blue);
-  polygon->rotation = INITIAL_ROTANG;
+  polygon->color = (rgb_color_t){red, green, blue};
+  polygon->position = centroid;
+  set_transform_rotation(polygon, INITIAL_ROTANG);
+  polygon->area = compute_area(polygon->local, num_points);
+  polygon->local_aabb = compute_aabb(polygon->local, num_points);
+  invalidate(polygon, true);
   return polygon;
 }
 
-list_t *polygon_get_points(polygon_t *polygon) { return polygon->points; }
+shape_view_t polygon_get_view(polygon_t *polygon) {
+  update_world(polygon);
+  return (shape_view_t){.points = polygon->world, .size = polygon->num_points};
+}
+
+shape_view_t polygon_get_local_view(polygon_t *polygon) {
+  return (shape_view_t){.points = polygon->local, .size = polygon->num_points};
+}
+
+const vector_t *polygon_get_normals(polygon_t *polygon) {
+  update_normals(polygon);
+  return polygon->world_normals;
+}
+
+polygon_kind_t polygon_get_kind(polygon_t *polygon) { return polygon->kind; }
+
+box_t polygon_get_box(polygon_t *polygon) {
+  assert(polygon->kind == POLYGON_BOX);
+  double c = polygon->cos_rotation;
+  double s = polygon->sin_rotation;
+  box_t box = {.center = polygon->position};
+  for (size_t i = 0; i < BOX_NUM_AXES; i++) {
+    vector_t axis = polygon->box_axes[i];
+    box.axes[i] = (vector_t){axis.x * c - axis.y * s, axis.x * s + axis.y * c};
+    box.half_extents[i] = polygon->box_half_extents[i];
+  }
+  return box;
+}
+
+size_t polygon_num_points(polygon_t *polygon) { return polygon->num_points; }
+
+vector_t polygon_get_point(polygon_t *polygon, size_t index) {
+  assert(index < polygon->num_points);
+  update_world(polygon);
+  return polygon->world[index];
+}
 
 void polygon_move(polygon_t *polygon, double time_elapsed) {
   vector_t displacement = vec_multiply(time_elapsed, polygon->velocity);
   polygon_translate(polygon, displacement);
-  polygon->rotation += polygon->rotation_speed * time_elapsed;
-  polygon_rotate(polygon, polygon_get_rotation(polygon),
-                 polygon_centroid(polygon));
+  polygon_set_rotation(polygon, polygon->rotation +
+                                    polygon->rotation_speed * time_elapsed);
 }
 
 void polygon_set_velocity(polygon_t *polygon, vector_t vel) {
@@ -45,95 +297,68 @@ void polygon_set_velocity(polygon_t *polygon, vector_t vel) {
   polygon->velocity.y = vel.y;
 }
 
-void polygon_free(polygon_t *polygon) {
-  list_t *points = polygon->points;
-  color_free(polygon->color);
-  list_free(points);
-  free(polygon);
-}
+void polygon_free(polygon_t *polygon) { free(polygon); }
 
 vector_t *polygon_get_velocity(polygon_t *polygon) {
   return &polygon->velocity;
 }
 
-double polygon_area(polygon_t *polygon) {
-  double area = 0;
-  size_t size = list_size(polygon->points);
-  if (size < 3)
-    return area;
+double polygon_area(polygon_t *polygon) { return polygon->area; }
 
-  // shoelace formula
-  for (size_t i = 0; i < size; i++) {
-    size_t next_idx = (i + 1) % size;
-    vector_t *p1 = list_get(polygon->points, i);
-    vector_t *p2 = list_get(polygon->points, next_idx);
-    area += vec_cross(*p1, *p2);
-  }
-  return 0.5 * fabs(area);
-}
-
-vector_t polygon_centroid(polygon_t *polygon) {
-  double signed_area = 0;
-  size_t size = list_size(polygon->points);
-  vector_t centroid = {0, 0};
+vector_t polygon_centroid(polygon_t *polygon) { return polygon->position; }
 
-  // signed area using shoelace formula
-  for (size_t i = 0; i < size; i++) {
-    size_t next_idx = (i + 1) % size;
-    vector_t *current = list_get(polygon->points, next_idx);
-    vector_t *prev = list_get(polygon->points, i);
-    double cross_prod = vec_cross(*prev, *current);
-    signed_area += cross_prod;
-    centroid.x += (current->x + prev->x) * cross_prod;
-    centroid.y += (current->y + prev->y) * cross_prod;
+aabb_t polygon_get_aabb(polygon_t *polygon) {
+  if (polygon->aabb_dirty) {
+    update_world(polygon);
+    polygon->aabb = compute_aabb(polygon->world, polygon->num_points);
+    polygon->aabb_dirty = false;
   }
+  return polygon->aabb;
+}
 
-  signed_area *= 0.5;
-  centroid.x /= CENTROID_SCALE * signed_area;
-  centroid.y /= CENTROID_SCALE * signed_area;
-  return centroid;
+aabb_t polygon_get_unrotated_aabb(polygon_t *polygon) {
+  return (aabb_t){.min = vec_add(polygon->position, polygon->local_aabb.min),
+                  .max = vec_add(polygon->position, polygon->local_aabb.max)};
 }
 
 void polygon_translate(polygon_t *polygon, vector_t translation) {
-  for (size_t i = 0; i < list_size(polygon->points); i++) {
-    vector_t *vertex = list_get(polygon->points, i);
-    *vertex = vec_add(*vertex, translation);
-  }
+  polygon->position = vec_add(polygon->position, translation);
+  polygon->aabb.min = vec_add(polygon->aabb.min, translation);
+  polygon->aabb.max = vec_add(polygon->aabb.max, translation);
+  invalidate(polygon, false);
 }
 
 void polygon_rotate(polygon_t *polygon, double angle, vector_t point) {
-  // need to rotate around origin first
-  polygon_translate(polygon, vec_negate(point));
-
-  for (size_t i = 0; i < list_size(polygon->points); i++) {
-    vector_t *vertex = list_get(polygon->points, i);
-    *vertex = vec_rotate(*vertex, angle);
-  }
-
-  // then translate back to effectively rotate around point
-  polygon_translate(polygon, point);
+  // the centroid rotates about point and the shape turns by the same angle
+  vector_t offset = vec_subtract(polygon->position, point);
+  double cos_angle = cos(angle);
+  double sin_angle = sin(angle);
+  vector_t rotated = {offset.x * cos_angle - offset.y * sin_angle,
+                      offset.x * sin_angle + offset.y * cos_angle};
+  polygon->position = vec_add(rotated, point);
+  set_transform_rotation(polygon, polygon->rotation + angle);
+  invalidate(polygon, true);
 }
 
-rgb_color_t *polygon_get_color(polygon_t *polygon) { return polygon->color; }
+rgb_color_t *polygon_get_color(polygon_t *polygon) { return &polygon->color; }
 
 void polygon_set_color(polygon_t *polygon, rgb_color_t *color) {
-  rgb_color_t *prev = polygon->color;
-  polygon->color = color;
-  color_free(prev);
+  polygon->color = *color;
+  color_free(color);
 }
 
 void polygon_set_center(polygon_t *polygon, vector_t centroid) {
-  polygon_translate(polygon,
-                    vec_subtract(centroid, polygon_get_center(polygon)));
+  polygon_translate(polygon, vec_subtract(centroid, polygon->position));
 }
 
-vector_t polygon_get_center(polygon_t *polygon) {
-  return polygon_centroid(polygon);
-}
+vector_t polygon_get_center(polygon_t *polygon) { return polygon->position; }
 
 void polygon_set_rotation(polygon_t *polygon, double rot) {
-  polygon_rotate(polygon, rot - polygon->rotation, polygon_get_center(polygon));
-  polygon->rotation = rot;
+  if (rot == polygon->rotation) {
+    return;
+  }
+  set_transform_rotation(polygon, rot);
+  invalidate(polygon, true);
 }
 
 double polygon_get_rotation(polygon_t *polygon) { return polygon->rotation; }
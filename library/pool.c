@@ -0,0 +1,89 @@
+#include <assert.h>
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "pool.h"
+#define ALLOC_TAG ALLOC_TAG_CORE
+#include "alloc.h"
+
+/**
+ * A batch of blocks. The blocks follow the header.
+ */
+typedef struct pool_chunk {
+  struct pool_chunk *next;
+  alignas(max_align_t) unsigned char data[];
+} pool_chunk_t;
+
+/**
+ * A block on the free list. Only released blocks are viewed this way.
+ */
+typedef struct free_block {
+  struct free_block *next;
+} free_block_t;
+
+struct pool {
+  size_t block_size;
+  size_t blocks_per_chunk;
+  pool_chunk_t *chunks;
+  free_block_t *free_blocks;
+};
+
+pool_t *pool_init(size_t block_size, size_t blocks_per_chunk) {
+  assert(blocks_per_chunk > 0);
+  pool_t *pool = malloc(sizeof(pool_t));
+  assert(pool != NULL);
+  // every block must hold a free list link and keep the next one aligned
+  size_t alignment = alignof(max_align_t);
+  if (block_size < sizeof(free_block_t)) {
+    block_size = sizeof(free_block_t);
+  }
+  pool->block_size = (block_size + alignment - 1) / alignment * alignment;
+  pool->blocks_per_chunk = blocks_per_chunk;
+  pool->chunks = NULL;
+  pool->free_blocks = NULL;
+  return pool;
+}
+
+void pool_free(pool_t *pool) {
+  pool_chunk_t *chunk = pool->chunks;
+  while (chunk != NULL) {
+    pool_chunk_t *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  free(pool);
+}
+
+/**
+ * Allocates another chunk and puts all of its blocks on the free list.
+ */
+static void add_chunk(pool_t *pool) {
+  pool_chunk_t *chunk =
+      malloc(sizeof(pool_chunk_t) + pool->blocks_per_chunk * pool->block_size);
+  assert(chunk != NULL);
+  chunk->next = pool->chunks;
+  pool->chunks = chunk;
+  // link the blocks back to front so they are handed out in address order
+  for (size_t i = pool->blocks_per_chunk; i > 0; i--) {
+    free_block_t *block =
+        (free_block_t *)&chunk->data[(i - 1) * pool->block_size];
+    block->next = pool->free_blocks;
+    pool->free_blocks = block;
+  }
+}
+
+void *pool_alloc(pool_t *pool) {
+  if (pool->free_blocks == NULL) {
+    add_chunk(pool);
+  }
+  free_block_t *block = pool->free_blocks;
+  pool->free_blocks = block->next;
+  return block;
+}
+
+void pool_release(pool_t *pool, void *block) {
+  free_block_t *released = block;
+  released->next = pool->free_blocks;
+  pool->free_blocks = released;
+}
@@ -7,98 +7,862 @@
 // };
 
 #include <assert.h>
+#include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "body.h"
+#include "collision.h"
 #include "forces.h"
+#include "integrator.h"
 #include "list.h"
 #include "polygon.h"
 #include "scene.h"
+#include "thread_pool.h"
+#include "vector_field.h"
+#define ALLOC_TAG ALLOC_TAG_PHYSICS
+#include "alloc.h"
 
 size_t const BODY_N = 0;
+uint32_t const NO_FREE_SLOT = UINT32_MAX;
+uint32_t const FIRST_GENERATION = 1;
+size_t const INITIAL_BROADPHASE_CAPACITY = 16;
+size_t const BROADPHASE_GROWTH_FACTOR = 2;
+// inverse mass, then velocity, force, impulse, last acceleration and
+// displacement per axis
+size_t const NUM_BODY_ARRAYS = 15;
+// the number of bodies or force jobs each task of the thread pool handles
+size_t const INTEGRATION_CHUNK_SIZE = 1024;
+size_t const FORCE_JOB_CHUNK_SIZE = 64;
+
+/**
+ * A collision registered with scene_add_category_collision().
+ */
+typedef struct collision_rule {
+  body_category_t category_a;
+  body_category_t category_b;
+  collision_handler_t handler;
+  void *aux;
+  double force_const;
+} collision_rule_t;
+
+/**
+ * A half-plane bounding the world, registered with scene_add_bound().
+ */
+typedef struct world_bound {
+  vector_t normal;
+  double offset;
+  body_category_t category;
+  collision_handler_t handler;
+  void *aux;
+  double force_const;
+} world_bound_t;
+
+/**
+ * A body and its bounding box, as sorted by the broadphase.
+ */
+typedef struct broadphase_entry {
+  body_t *body;
+  aabb_t aabb;
+} broadphase_entry_t;
+
+/**
+ * A pair of bodies that are colliding under a given rule, or a body that is
+ * crossing a given world bound (in which case body2 is NULL).
+ */
+typedef struct contact {
+  const void *source;
+  body_t *body1;
+  body_t *body2;
+} contact_t;
+
+/**
+ * An entry of the slot map from body handles to bodies. While the slot is
+ * in use, dense_index is the body's index in the scene's body array;
+ * otherwise it links to the next free slot.
+ */
+typedef struct body_slot {
+  uint32_t generation;
+  uint32_t dense_index;
+} body_slot_t;
+
+/**
+ * A body in the scene's dense body array, and the slot it occupies.
+ */
+typedef struct dense_body {
+  body_t *body;
+  uint32_t slot;
+} dense_body_t;
+
+/**
+ * The integration state of the scene's bodies in structure-of-arrays form,
+ * indexed like the dense body array. All arrays share one allocation.
+ */
+typedef struct body_arrays {
+  double *block;
+  size_t capacity;
+  // the body each element belongs to
+  body_t **bodies;
+  double *inv_mass;
+  double *velocity_x;
+  double *velocity_y;
+  double *force_x;
+  double *force_y;
+  double *impulse_x;
+  double *impulse_y;
+  double *last_acceleration_x;
+  double *last_acceleration_y;
+  double *displacement_x;
+  double *displacement_y;
+  // only filled in when the scene has a vector field
+  double *position_x;
+  double *position_y;
+  double *field_x;
+  double *field_y;
+} body_arrays_t;
+
+/**
+ * A growable array of contacts.
+ */
+typedef struct contact_set {
+  contact_t *contacts;
+  size_t size;
+  size_t capacity;
+} contact_set_t;
 
 struct scene {
+  // bodies stored densely, so iterating over them skips empty slots
   size_t num_bodies;
-  list_t *bodies;
+  size_t bodies_capacity;
+  dense_body_t *bodies;
+  // slot map for body handles, with a free list threaded through it
+  body_slot_t *slots;
+  size_t num_slots;
+  size_t slots_capacity;
+  uint32_t free_slot;
+  // the memory of bodies made with scene_get_body_pool()
+  body_pool_t *body_pool;
+  // refilled from the bodies each tick and integrated in one batch
+  body_arrays_t arrays;
+  integrator_t integrator;
+  // the field accelerating every dynamic body, sampled at the scene's time
+  const vector_field_t *vector_field;
+  double time;
+  thread_pool_t *pool;
+  // the parallel force jobs of the current tick, the forces each chunk of
+  // them added, and where each job's forces end in its chunk's buffer
+  force_job_t **parallel_jobs;
+  size_t parallel_jobs_capacity;
+  size_t *force_ends;
+  body_force_buffer_t *force_buffers;
+  size_t num_force_buffers;
   list_t *force_creators;
   list_t *force_jobs;
+  list_t *collision_rules;
+  list_t *bounds;
+  // reused each tick so the broadphase does not allocate once warmed up
+  broadphase_entry_t *entries;
+  size_t entries_capacity;
+  // pairs colliding as of the last tick, and those found in the current tick
+  contact_set_t contacts;
+  contact_set_t next_contacts;
 };
 
 scene_t *scene_init(void) {
   scene_t *new = malloc(sizeof(scene_t));
   assert(new != NULL);
-  new->bodies = list_init(BODY_N, (free_func_t)body_free);
   new->num_bodies = 0;
+  new->bodies_capacity = 0;
+  new->bodies = NULL;
+  new->slots = NULL;
+  new->num_slots = 0;
+  new->slots_capacity = 0;
+  new->free_slot = NO_FREE_SLOT;
+  new->body_pool = body_pool_init();
+  new->arrays = (body_arrays_t){.block = NULL, .capacity = 0, .bodies = NULL};
+  new->integrator = INTEGRATOR_AVERAGE_VELOCITY;
+  new->vector_field = NULL;
+  new->time = 0;
+  new->pool = NULL;
+  new->parallel_jobs = NULL;
+  new->parallel_jobs_capacity = 0;
+  new->force_ends = NULL;
+  new->force_buffers = NULL;
+  new->num_force_buffers = 0;
   new->force_jobs = list_init(BODY_N, (free_func_t)forces_job_free);
+  new->collision_rules = list_init(BODY_N, free);
+  new->bounds = list_init(BODY_N, free);
+  new->entries = NULL;
+  new->entries_capacity = 0;
+  new->contacts = (contact_set_t){NULL, 0, 0};
+  new->next_contacts = (contact_set_t){NULL, 0, 0};
   return new;
 }
 
-void scene_tick(scene_t *scene, double dt) {
-  for (size_t i = 0; i < list_size(scene->force_jobs); i++) {
-    forces_job_run(list_get(scene->force_jobs, i));
+/**
+ * Grows an array, if needed, so that it can hold the given number of elements.
+ *
+ * @param array the array to grow, or NULL
+ * @param capacity the current capacity of the array, updated if it grows
+ * @param needed the number of elements the array must hold
+ * @param elem_size the size of each element
+ * @return the possibly reallocated array
+ */
+static void *reserve(void *array, size_t *capacity, size_t needed,
+                     size_t elem_size) {
+  if (needed <= *capacity) {
+    return array;
+  }
+  size_t new_capacity = *capacity == 0 ? INITIAL_BROADPHASE_CAPACITY
+                                       : *capacity * BROADPHASE_GROWTH_FACTOR;
+  while (new_capacity < needed) {
+    new_capacity *= BROADPHASE_GROWTH_FACTOR;
+  }
+  array = realloc(array, new_capacity * elem_size);
+  assert(array != NULL);
+  *capacity = new_capacity;
+  return array;
+}
+
+static void contact_set_add(contact_set_t *set, contact_t contact) {
+  set->contacts = reserve(set->contacts, &set->capacity, set->size + 1,
+                          sizeof(contact_t));
+  set->contacts[set->size++] = contact;
+}
+
+static bool contact_set_contains(contact_set_t *set, contact_t contact) {
+  for (size_t i = 0; i < set->size; i++) {
+    contact_t *other = &set->contacts[i];
+    if (other->source == contact.source && other->body1 == contact.body1 &&
+        other->body2 == contact.body2) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Forgets every contact involving a body, so that a body allocated later at
+ * the same address does not inherit them.
+ */
+static void contact_set_remove_body(contact_set_t *set, body_t *body) {
+  for (size_t i = 0; i < set->size;) {
+    contact_t *contact = &set->contacts[i];
+    if (contact->body1 == body || contact->body2 == body) {
+      *contact = set->contacts[--set->size];
+    } else {
+      i++;
+    }
+  }
+}
+
+static int compare_entries(const void *a, const void *b) {
+  double min_a = ((const broadphase_entry_t *)a)->aabb.min.x;
+  double min_b = ((const broadphase_entry_t *)b)->aabb.min.x;
+  return (min_a > min_b) - (min_a < min_b);
+}
+
+static bool rule_matches(collision_rule_t *rule, body_t *body1,
+                         body_t *body2) {
+  return (body_get_category(body1) & rule->category_a) &&
+         (body_get_category(body2) & rule->category_b);
+}
+
+/**
+ * Runs the narrowphase on a pair of bodies whose bounding boxes overlap,
+ * calling the handler of every matching rule for which the pair has just
+ * started colliding.
+ */
+static void handle_pair(scene_t *scene, body_t *a, body_t *b) {
+  for (size_t i = 0; i < list_size(scene->collision_rules); i++) {
+    // a handler may have removed one of the bodies
+    if (body_is_removed(a) || body_is_removed(b)) {
+      return;
+    }
+    collision_rule_t *rule = list_get(scene->collision_rules, i);
+    body_t *body1;
+    body_t *body2;
+    if (rule_matches(rule, a, b)) {
+      body1 = a;
+      body2 = b;
+    } else if (rule_matches(rule, b, a)) {
+      body1 = b;
+      body2 = a;
+    } else {
+      continue;
+    }
+
+    collision_info_t info = find_collision(body1, body2);
+    if (!info.collided) {
+      continue;
+    }
+    contact_t contact = {.source = rule, .body1 = body1, .body2 = body2};
+    contact_set_add(&scene->next_contacts, contact);
+    // avoids registering impulse multiple times while bodies are still
+    // colliding
+    if (!contact_set_contains(&scene->contacts, contact)) {
+      collision_move_to_contact(body1, body2, info);
+      rule->handler(body1, body2, info.axis, rule->aux, rule->force_const);
+    }
+  }
+}
+
+/**
+ * Returns whether any vertex of a body is outside a world bound.
+ * Bodies whose bounding box is entirely inside are rejected without looking
+ * at their vertices.
+ */
+static bool crosses_bound(world_bound_t *bound, body_t *body, aabb_t aabb) {
+  vector_t n = bound->normal;
+  // the corner of the bounding box furthest along -normal
+  vector_t corner = {n.x >= 0 ? aabb.min.x : aabb.max.x,
+                     n.y >= 0 ? aabb.min.y : aabb.max.y};
+  if (vec_dot(n, corner) >= bound->offset) {
+    return false;
   }
+  shape_view_t shape = body_get_shape_view(body);
+  for (size_t i = 0; i < shape.size; i++) {
+    if (vec_dot(n, shape.points[i]) < bound->offset) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Tests every categorized body against the world bounds, calling the
+ * handler of each bound that a body has just started crossing.
+ */
+static void handle_bounds(scene_t *scene, size_t num_entries) {
+  for (size_t i = 0; i < list_size(scene->bounds); i++) {
+    world_bound_t *bound = list_get(scene->bounds, i);
+    for (size_t j = 0; j < num_entries; j++) {
+      body_t *body = scene->entries[j].body;
+      if (body_is_removed(body) ||
+          !(body_get_category(body) & bound->category) ||
+          !crosses_bound(bound, body, scene->entries[j].aabb)) {
+        continue;
+      }
+      contact_t contact = {.source = bound, .body1 = body, .body2 = NULL};
+      contact_set_add(&scene->next_contacts, contact);
+      if (!contact_set_contains(&scene->contacts, contact)) {
+        bound->handler(body, NULL, vec_negate(bound->normal), bound->aux,
+                       bound->force_const);
+      }
+    }
+  }
+}
+
+/**
+ * Finds the pairs of categorized bodies whose bounding boxes overlap by
+ * sweep-and-prune along the x axis, and handles each of them.
+ */
+static void detect_collisions(scene_t *scene) {
+  if (list_size(scene->collision_rules) == 0 &&
+      list_size(scene->bounds) == 0) {
+    return;
+  }
+
+  size_t num_entries = 0;
+  for (size_t i = 0; i < scene->num_bodies; i++) {
+    body_t *body = scene->bodies[i].body;
+    if (body_is_removed(body) || body_get_category(body) == 0) {
+      continue;
+    }
+    scene->entries = reserve(scene->entries, &scene->entries_capacity,
+                             num_entries + 1, sizeof(broadphase_entry_t));
+    scene->entries[num_entries++] =
+        (broadphase_entry_t){.body = body, .aabb = body_get_swept_aabb(body)};
+  }
+  qsort(scene->entries, num_entries, sizeof(broadphase_entry_t),
+        compare_entries);
+
+  scene->next_contacts.size = 0;
+  for (size_t i = 0; i < num_entries; i++) {
+    aabb_t box = scene->entries[i].aabb;
+    for (size_t j = i + 1;
+         j < num_entries && scene->entries[j].aabb.min.x <= box.max.x; j++) {
+      aabb_t other = scene->entries[j].aabb;
+      body_t *body1 = scene->entries[i].body;
+      body_t *body2 = scene->entries[j].body;
+      if (other.min.y <= box.max.y && box.min.y <= other.max.y &&
+          !(body_get_type(body1) == BODY_STATIC &&
+            body_get_type(body2) == BODY_STATIC)) {
+        handle_pair(scene, body1, body2);
+      }
+    }
+  }
+  handle_bounds(scene, num_entries);
+
+  contact_set_t previous = scene->contacts;
+  scene->contacts = scene->next_contacts;
+  scene->next_contacts = previous;
+}
+
+void scene_add_category_collision(scene_t *scene, body_category_t category_a,
+                                  body_category_t category_b,
+                                  collision_handler_t handler, void *aux,
+                                  double force_const) {
+  collision_rule_t *rule = malloc(sizeof(collision_rule_t));
+  assert(rule != NULL);
+  rule->category_a = category_a;
+  rule->category_b = category_b;
+  rule->handler = handler;
+  rule->aux = aux;
+  rule->force_const = force_const;
+  list_add(scene->collision_rules, rule);
+}
+
+void scene_add_bound(scene_t *scene, vector_t normal, double offset,
+                     body_category_t category, collision_handler_t handler,
+                     void *aux, double force_const) {
+  world_bound_t *bound = malloc(sizeof(world_bound_t));
+  assert(bound != NULL);
+  bound->normal = normal;
+  bound->offset = offset;
+  bound->category = category;
+  bound->handler = handler;
+  bound->aux = aux;
+  bound->force_const = force_const;
+  list_add(scene->bounds, bound);
+}
+
+/**
+ * Marks every force job acting on a removed body for removal.
+ *
+ * @return the number of force jobs newly marked
+ */
+static size_t remove_force_jobs_of(body_t *body) {
+  size_t num_removed = 0;
+  for (size_t i = 0; i < body_num_force_jobs(body); i++) {
+    force_job_t *force_job = body_get_force_job(body, i);
+    if (!forces_job_is_removed(force_job)) {
+      forces_job_remove(force_job);
+      num_removed++;
+    }
+  }
+  return num_removed;
+}
+
+/**
+ * Grows the body arrays, if needed, so they can hold every body in the scene.
+ */
+static void reserve_body_arrays(scene_t *scene) {
+  body_arrays_t *arrays = &scene->arrays;
+  size_t capacity = arrays->capacity;
+  arrays->block = reserve(arrays->block, &arrays->capacity, scene->num_bodies,
+                          NUM_BODY_ARRAYS * sizeof(double));
+  if (arrays->capacity == capacity) {
+    return;
+  }
+  arrays->bodies = realloc(arrays->bodies, arrays->capacity * sizeof(body_t *));
+  assert(arrays->bodies != NULL);
+  double *next = arrays->block;
+  double **fields[] = {
+      &arrays->inv_mass,           &arrays->velocity_x,
+      &arrays->velocity_y,         &arrays->force_x,
+      &arrays->force_y,            &arrays->impulse_x,
+      &arrays->impulse_y,          &arrays->last_acceleration_x,
+      &arrays->last_acceleration_y, &arrays->displacement_x,
+      &arrays->displacement_y,     &arrays->position_x,
+      &arrays->position_y,         &arrays->field_x,
+      &arrays->field_y};
+  for (size_t i = 0; i < NUM_BODY_ARRAYS; i++) {
+    *fields[i] = next;
+    next += arrays->capacity;
+  }
+}
+
+/**
+ * The arguments of integrate_chunk().
+ */
+typedef struct integration_task {
+  scene_t *scene;
+  double dt;
+} integration_task_t;
+
+/**
+ * Samples the scene's vector field at the dynamic bodies at the indices
+ * [begin, end) in one batch, into the field arrays.
+ */
+static void sample_vector_field(scene_t *scene, size_t begin, size_t end) {
+  body_arrays_t *arrays = &scene->arrays;
+  for (size_t i = begin; i < end; i++) {
+    vector_t position = body_get_centroid(arrays->bodies[i]);
+    arrays->position_x[i] = position.x;
+    arrays->position_y[i] = position.y;
+  }
+  vector_field_sample(scene->vector_field, scene->time,
+                      &arrays->position_x[begin], &arrays->position_y[begin],
+                      &arrays->field_x[begin], &arrays->field_y[begin],
+                      end - begin);
+}
 
-  for (ssize_t i = 0; i < (ssize_t)(list_size(scene->bodies)); i++) {
-    body_t *body = list_get(scene->bodies, i);
-    // Case 1: the body is removed
+/**
+ * Integrates the dynamic bodies gathered into the body arrays at the indices
+ * [begin, end): adds the forces from the vector field, fills in their state,
+ * runs integrator_step() over them, and writes back the results. Chunks
+ * touch disjoint bodies, so they can run in parallel.
+ */
+static void integrate_chunk(void *aux, size_t begin, size_t end) {
+  integration_task_t *task = aux;
+  scene_t *scene = task->scene;
+  body_arrays_t *arrays = &scene->arrays;
+  bool has_field = scene->vector_field != NULL;
+  if (has_field) {
+    sample_vector_field(scene, begin, end);
+  }
+  for (size_t i = begin; i < end; i++) {
+    body_t *body = arrays->bodies[i];
+    double mass = body_get_mass(body);
+    // a body of infinite mass is not accelerated by the field
+    if (has_field && mass != INFINITY) {
+      vector_t acceleration = {arrays->field_x[i], arrays->field_y[i]};
+      body_add_force(body, vec_multiply(mass, acceleration));
+    }
+    vector_t velocity = body_get_velocity(body);
+    vector_t force = body_get_force(body);
+    vector_t impulse = body_get_impulse(body);
+    arrays->inv_mass[i] = 1.0 / mass;
+    arrays->velocity_x[i] = velocity.x;
+    arrays->velocity_y[i] = velocity.y;
+    arrays->force_x[i] = force.x;
+    arrays->force_y[i] = force.y;
+    arrays->impulse_x[i] = impulse.x;
+    arrays->impulse_y[i] = impulse.y;
+    if (scene->integrator == INTEGRATOR_VELOCITY_VERLET) {
+      vector_t last_acceleration = body_get_last_acceleration(body);
+      arrays->last_acceleration_x[i] = last_acceleration.x;
+      arrays->last_acceleration_y[i] = last_acceleration.y;
+    }
+  }
+
+  integrator_step(scene->integrator,
+                  (integrator_axis_t){&arrays->velocity_x[begin],
+                                      &arrays->force_x[begin],
+                                      &arrays->impulse_x[begin],
+                                      &arrays->inv_mass[begin],
+                                      &arrays->last_acceleration_x[begin],
+                                      &arrays->displacement_x[begin]},
+                  end - begin, task->dt);
+  integrator_step(scene->integrator,
+                  (integrator_axis_t){&arrays->velocity_y[begin],
+                                      &arrays->force_y[begin],
+                                      &arrays->impulse_y[begin],
+                                      &arrays->inv_mass[begin],
+                                      &arrays->last_acceleration_y[begin],
+                                      &arrays->displacement_y[begin]},
+                  end - begin, task->dt);
+
+  for (size_t i = begin; i < end; i++) {
+    vector_t velocity = {arrays->velocity_x[i], arrays->velocity_y[i]};
+    vector_t displacement = {arrays->displacement_x[i],
+                             arrays->displacement_y[i]};
+    body_advance(arrays->bodies[i], velocity, displacement);
+  }
+}
+
+/**
+ * Ticks every body that is not marked for removal. Dynamic bodies are
+ * ticked like body_tick(), but integrated in batches with integrator_step(),
+ * on the scene's thread pool if it has one. Kinematic bodies only move at
+ * their velocity and static bodies are skipped.
+ */
+static void integrate_bodies(scene_t *scene, double dt) {
+  reserve_body_arrays(scene);
+  body_arrays_t *arrays = &scene->arrays;
+  size_t num_dynamic = 0;
+  for (size_t i = 0; i < scene->num_bodies; i++) {
+    body_t *body = scene->bodies[i].body;
+    if (body_is_removed(body)) {
+      continue;
+    }
+    body_type_t type = body_get_type(body);
+    if (type == BODY_DYNAMIC) {
+      arrays->bodies[num_dynamic++] = body;
+    } else if (type == BODY_KINEMATIC) {
+      vector_t velocity = body_get_velocity(body);
+      body_advance(body, velocity, vec_multiply(dt, velocity));
+    }
+  }
+  integration_task_t task = {.scene = scene, .dt = dt};
+  thread_pool_parallel_for(scene->pool, num_dynamic, INTEGRATION_CHUNK_SIZE,
+                           integrate_chunk, &task);
+}
+
+static bool is_force_job_removed(void *force_job, void *aux) {
+  return forces_job_is_removed(force_job);
+}
+
+/**
+ * Frees the body at an index of the dense array and releases its slot,
+ * moving the last body into its place.
+ */
+static void remove_dense_body(scene_t *scene, size_t index) {
+  uint32_t slot = scene->bodies[index].slot;
+  scene->slots[slot].generation++;
+  scene->slots[slot].dense_index = scene->free_slot;
+  scene->free_slot = slot;
+  body_free(scene->bodies[index].body);
+
+  size_t last = --scene->num_bodies;
+  if (index != last) {
+    scene->bodies[index] = scene->bodies[last];
+    scene->slots[scene->bodies[index].slot].dense_index = index;
+  }
+}
+
+/**
+ * Runs a chunk of the parallel force jobs, recording the forces they add in
+ * the chunk's buffer.
+ */
+static void run_force_job_chunk(void *aux, size_t begin, size_t end) {
+  scene_t *scene = aux;
+  body_force_buffer_t *buffer =
+      &scene->force_buffers[begin / FORCE_JOB_CHUNK_SIZE];
+  buffer->size = 0;
+  body_defer_forces(buffer);
+  for (size_t i = begin; i < end; i++) {
+    forces_job_run(scene->parallel_jobs[i]);
+    scene->force_ends[i] = buffer->size;
+  }
+  body_defer_forces(NULL);
+}
+
+/**
+ * Runs every force job. Parallel jobs run on the thread pool first, then
+ * their forces are applied while the other jobs run, all in the order of the
+ * job list, so the sums come out the same for any number of threads.
+ */
+static void run_force_jobs(scene_t *scene) {
+  size_t num_jobs = list_size(scene->force_jobs);
+  size_t num_parallel = 0;
+  if (scene->pool != NULL && thread_pool_num_workers(scene->pool) > 1) {
+    for (size_t i = 0; i < num_jobs; i++) {
+      force_job_t *job = list_get(scene->force_jobs, i);
+      if (!forces_job_is_parallel(job)) {
+        continue;
+      }
+      size_t capacity = scene->parallel_jobs_capacity;
+      scene->parallel_jobs =
+          reserve(scene->parallel_jobs, &scene->parallel_jobs_capacity,
+                  num_parallel + 1, sizeof(force_job_t *));
+      if (scene->parallel_jobs_capacity != capacity) {
+        scene->force_ends = realloc(
+            scene->force_ends, scene->parallel_jobs_capacity * sizeof(size_t));
+        assert(scene->force_ends != NULL);
+      }
+      scene->parallel_jobs[num_parallel++] = job;
+    }
+  }
+  if (num_parallel == 0) {
+    for (size_t i = 0; i < num_jobs; i++) {
+      forces_job_run(list_get(scene->force_jobs, i));
+    }
+    return;
+  }
+
+  size_t num_chunks =
+      (num_parallel + FORCE_JOB_CHUNK_SIZE - 1) / FORCE_JOB_CHUNK_SIZE;
+  if (num_chunks > scene->num_force_buffers) {
+    scene->force_buffers = realloc(scene->force_buffers,
+                                   num_chunks * sizeof(body_force_buffer_t));
+    assert(scene->force_buffers != NULL);
+    for (size_t i = scene->num_force_buffers; i < num_chunks; i++) {
+      scene->force_buffers[i] = (body_force_buffer_t){NULL, 0, 0};
+    }
+    scene->num_force_buffers = num_chunks;
+  }
+  thread_pool_parallel_for(scene->pool, num_parallel, FORCE_JOB_CHUNK_SIZE,
+                           run_force_job_chunk, scene);
+
+  size_t parallel_index = 0;
+  size_t next_force = 0;
+  for (size_t i = 0; i < num_jobs; i++) {
+    force_job_t *job = list_get(scene->force_jobs, i);
+    if (!forces_job_is_parallel(job)) {
+      forces_job_run(job);
+      continue;
+    }
+    if (parallel_index % FORCE_JOB_CHUNK_SIZE == 0) {
+      next_force = 0;
+    }
+    body_force_buffer_t *buffer =
+        &scene->force_buffers[parallel_index / FORCE_JOB_CHUNK_SIZE];
+    for (; next_force < scene->force_ends[parallel_index]; next_force++) {
+      body_force_t force = buffer->forces[next_force];
+      if (force.is_impulse) {
+        body_add_impulse(force.body, force.value);
+      } else {
+        body_add_force(force.body, force.value);
+      }
+    }
+    parallel_index++;
+  }
+}
+
+void scene_tick(scene_t *scene, double dt) {
+  run_force_jobs(scene);
+  detect_collisions(scene);
+  integrate_bodies(scene, dt);
+  scene->time += dt;
+
+  // removed bodies and their jobs are left in place as tombstones
+  size_t num_removed = 0;
+  size_t num_jobs_removed = 0;
+  for (size_t i = 0; i < scene->num_bodies; i++) {
+    body_t *body = scene->bodies[i].body;
     if (body_is_removed(body)) {
-      for (size_t j = 0; j < list_size(scene->force_jobs); j++) {
-        force_job_t *force_job = list_get(scene->force_jobs, j);
-        list_t *bodies = force_job_get_bodies(force_job);
-
-        for (size_t k = 0; k < list_size(bodies); k++) {
-          body_t *force_body = list_get(bodies, k);
-          if (force_body == body) {
-            list_remove(scene->force_jobs, j);
-            j--;
-            forces_job_free(force_job);
-            break;
-          }
-        }
+      num_jobs_removed += remove_force_jobs_of(body);
+      contact_set_remove_body(&scene->contacts, body);
+      num_removed++;
+    }
+  }
+  if (num_removed == 0) {
+    return;
+  }
+
+  // then compacted in one pass each: the remaining bodies first drop their
+  // references to removed jobs, then the jobs are freed, then the bodies
+  if (num_jobs_removed > 0) {
+    for (size_t i = 0; i < scene->num_bodies; i++) {
+      body_t *body = scene->bodies[i].body;
+      if (!body_is_removed(body)) {
+        body_remove_force_jobs_if(body, is_force_job_removed);
       }
-      list_remove(scene->bodies, i);
-      i--;
-      body_free(body);
-      scene->num_bodies--;
+    }
+    list_remove_if(scene->force_jobs, is_force_job_removed, NULL);
+  }
+  for (size_t i = 0; i < scene->num_bodies;) {
+    if (body_is_removed(scene->bodies[i].body)) {
+      remove_dense_body(scene, i);
     } else {
-      // Case 2: the body isn't removed
-      body_tick(body, dt);
+      i++;
     }
   }
 }
 
 void scene_add_force_creator(scene_t *scene, force_creator_t force_creator,
                              void *aux) {
-  scene_add_bodies_force_creator(scene, force_creator, aux, list_init(0, free));
+  scene_add_bodies_force_creator(scene, force_creator, aux, list_init(0, NULL),
+                                 NULL);
+}
+
+force_job_t *scene_add_parallel_force_creator(scene_t *scene,
+                                              force_creator_t forcer, void *aux,
+                                              list_t *bodies,
+                                              free_func_t aux_freer) {
+  force_job_t *force_job =
+      scene_add_bodies_force_creator(scene, forcer, aux, bodies, aux_freer);
+  forces_job_set_parallel(force_job, true);
+  return force_job;
+}
+
+void scene_set_thread_pool(scene_t *scene, thread_pool_t *pool) {
+  scene->pool = pool;
+}
+
+void scene_set_vector_field(scene_t *scene, const vector_field_t *field) {
+  scene->vector_field = field;
 }
 
-void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
-                                    void *aux, list_t *bodies) {
-  // we need to keep track of `bodies` for each `forcer` somehow...
-  force_job_t *new_force_job = forces_job_init(forcer, aux, bodies);
-  list_add(scene->force_jobs, new_force_job);
+const vector_field_t *scene_get_vector_field(scene_t *scene) {
+  return scene->vector_field;
+}
+
+double scene_get_time(scene_t *scene) { return scene->time; }
+
+force_job_t *scene_add_bodies_force_creator(scene_t *scene,
+                                            force_creator_t forcer, void *aux,
+                                            list_t *bodies,
+                                            free_func_t aux_freer) {
+  force_job_t *new_force_job = forces_job_init(forcer, aux, bodies, aux_freer);
+  list_free(bodies);
+  scene_add_force_job(scene, new_force_job);
+  return new_force_job;
+}
+
+void scene_add_force_job(scene_t *scene, force_job_t *job) {
+  list_add(scene->force_jobs, job);
+  // each body keeps a reference to the job so removing it finds the job
+  for (size_t i = 0; i < forces_job_num_bodies(job); i++) {
+    body_add_force_job(forces_job_get_body(job, i), job);
+  }
 }
 
 void scene_free(scene_t *scene) {
-  list_free(scene->bodies);
+  // pooled bodies only go back on a free list here; their memory is released
+  // a chunk at a time with the pool
+  for (size_t i = 0; i < scene->num_bodies; i++) {
+    body_free(scene->bodies[i].body);
+  }
+  body_pool_free(scene->body_pool);
+  free(scene->bodies);
+  free(scene->slots);
+  free(scene->arrays.block);
+  free(scene->arrays.bodies);
+  free(scene->parallel_jobs);
+  free(scene->force_ends);
+  for (size_t i = 0; i < scene->num_force_buffers; i++) {
+    free(scene->force_buffers[i].forces);
+  }
+  free(scene->force_buffers);
   list_free(scene->force_jobs);
+  list_free(scene->collision_rules);
+  list_free(scene->bounds);
+  free(scene->entries);
+  free(scene->contacts.contacts);
+  free(scene->next_contacts.contacts);
   free(scene);
 }
 
+void scene_set_integrator(scene_t *scene, integrator_t integrator) {
+  scene->integrator = integrator;
+}
+
+integrator_t scene_get_integrator(scene_t *scene) { return scene->integrator; }
+
 size_t scene_bodies(scene_t *scene) { return scene->num_bodies; }
 
+body_pool_t *scene_get_body_pool(scene_t *scene) { return scene->body_pool; }
+
 body_t *scene_get_body(scene_t *scene, size_t index) {
   assert(index >= 0 && index < scene->num_bodies);
-  return list_get(scene->bodies, index);
+  return scene->bodies[index].body;
 }
 
-void scene_add_body(scene_t *scene, body_t *body) {
-  list_add(scene->bodies, body);
+body_handle_t scene_add_body(scene_t *scene, body_t *body) {
+  uint32_t slot = scene->free_slot;
+  if (slot != NO_FREE_SLOT) {
+    scene->free_slot = scene->slots[slot].dense_index;
+  } else {
+    scene->slots = reserve(scene->slots, &scene->slots_capacity,
+                           scene->num_slots + 1, sizeof(body_slot_t));
+    slot = scene->num_slots++;
+    scene->slots[slot].generation = FIRST_GENERATION;
+  }
+
+  scene->bodies = reserve(scene->bodies, &scene->bodies_capacity,
+                          scene->num_bodies + 1, sizeof(dense_body_t));
+  scene->slots[slot].dense_index = scene->num_bodies;
+  scene->bodies[scene->num_bodies] =
+      (dense_body_t){.body = body, .slot = slot};
   scene->num_bodies++;
+  return (body_handle_t){.index = slot,
+                         .generation = scene->slots[slot].generation};
+}
+
+body_t *scene_get_body_by_handle(scene_t *scene, body_handle_t handle) {
+  if (handle.index >= scene->num_slots ||
+      scene->slots[handle.index].generation != handle.generation) {
+    return NULL;
+  }
+  body_t *body = scene->bodies[scene->slots[handle.index].dense_index].body;
+  return body_is_removed(body) ? NULL : body;
 }
 
 void scene_remove_body(scene_t *scene, size_t index) {
-  body_t *new = list_get(scene->bodies, index);
+  body_t *new = scene->bodies[index].body;
   body_remove(new);
 }
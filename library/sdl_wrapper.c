@@ -6,7 +6,9 @@
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
-#include <time.h>
+#include "arena.h"
+#define ALLOC_TAG ALLOC_TAG_RENDER
+#include "alloc.h"
 
 const char WINDOW_TITLE[] = "CS 3";
 const int WINDOW_WIDTH = 1000;
@@ -18,7 +20,8 @@ const size_t CHUNK_SIZE = 2048;
 const ssize_t FIRST_FREE_CHANNEL = -1;
 const size_t NO_LOOPS = 0;
 const ssize_t INFINITE_LOOPS = -1;
-const size_t NUM_BOX_POINTS = 4;
+const size_t INITIAL_QUEUE_CAPACITY = 32;
+const size_t QUEUE_GROWTH_FACTOR = 2;
 
 /**
  * The coordinate at the center of the screen.
@@ -53,10 +56,10 @@ key_handler_t key_handler = NULL;
  */
 uint32_t key_start_timestamp;
 /**
- * The value of clock() when time_since_last_tick() was last called.
- * Initially 0.
+ * The value of SDL_GetPerformanceCounter() when time_since_last_tick() was
+ * last called. Initially 0.
  */
-clock_t last_clock = 0;
+uint64_t last_counter = 0;
 
 typedef struct sdl_mouse_handlers {
   state_mouse_handler_t start_screen_handler;
@@ -72,15 +75,55 @@ typedef struct sdl_mouse_handlers {
  */
 sdl_mouse_handlers_t mouse_handlers;
 
+typedef enum { DRAW_IMAGE, DRAW_POLYGON, DRAW_TEXT } draw_type_t;
+
+/**
+ * A single deferred draw, recorded by one of the sdl_queue_*() functions.
+ */
+typedef struct draw_command {
+  draw_type_t type;
+  size_t layer;
+  // the order the command was queued in, used to keep the sort stable
+  size_t seq;
+  // the SDL_Texture for images, the TTF_Font for text and NULL for polygons
+  void *texture;
+  SDL_Rect bounds;
+  double rot;
+  rgb_color_t color;
+  const char *text;
+  // range of this polygon's vertices in the queue's pixel buffers
+  size_t first_point;
+  size_t num_points;
+} draw_command_t;
+
+/**
+ * The draw commands queued since the last sdl_clear().
+ * The buffers are reused between frames and only grow.
+ */
+typedef struct render_queue {
+  draw_command_t *commands;
+  size_t size;
+  size_t capacity;
+  int16_t *x_points;
+  int16_t *y_points;
+  size_t num_points;
+  size_t points_capacity;
+} render_queue_t;
+
+render_queue_t render_queue = {0};
+/**
+ * Counters for the frame in progress and for the last completed frame.
+ */
+sdl_frame_stats_t frame_stats = {0};
+sdl_frame_stats_t last_frame_stats = {0};
+// the allocation count when the frame in progress started
+size_t frame_start_allocations = 0;
+
 /** Computes the center of the window in pixel coordinates */
 vector_t get_window_center(void) {
-  int *width = malloc(sizeof(*width)), *height = malloc(sizeof(*height));
-  assert(width != NULL);
-  assert(height != NULL);
-  SDL_GetWindowSize(window, width, height);
-  vector_t dimensions = {.x = *width, .y = *height};
-  free(width);
-  free(height);
+  int width, height;
+  SDL_GetWindowSize(window, &width, &height);
+  vector_t dimensions = {.x = width, .y = height};
   return vec_multiply(0.5, dimensions);
 }
 
@@ -164,13 +207,12 @@ void sdl_set_mouse_handlers(state_mouse_handler_t screen_switch, state_mouse_han
 }
 
 bool sdl_is_done(void *state) {
-  SDL_Event *event = malloc(sizeof(*event));
+  SDL_Event event_storage;
+  SDL_Event *event = &event_storage;
   level_t *cur_level = state_current_level(state);
-  assert(event != NULL);
   while (SDL_PollEvent(event)) {
     switch (event->type) {
     case SDL_QUIT:
-      free(event);
       return true;
     case SDL_KEYDOWN:
     case SDL_KEYUP:
@@ -222,58 +264,215 @@ bool sdl_is_done(void *state) {
     }
     }
   }
-  free(event);
   return false;
 }
 
 void sdl_clear(void) {
   SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
   SDL_RenderClear(renderer);
+  render_queue.size = 0;
+  render_queue.num_points = 0;
+  size_t allocations = alloc_get_count();
+  alloc_end_frame();
+  frame_stats.allocations = allocations - frame_start_allocations;
+  frame_start_allocations = allocations;
+  last_frame_stats = frame_stats;
+  frame_stats = (sdl_frame_stats_t){0};
+}
+
+/**
+ * Converts the vertices of a polygon to pixel coordinates and stores them at
+ * the end of the render queue's pixel buffers.
+ *
+ * @param poly the polygon to convert
+ * @return the index of the polygon's first vertex in the pixel buffers
+ */
+static size_t render_queue_add_points(polygon_t *poly, vector_t offset) {
+  shape_view_t points = polygon_get_view(poly);
+  size_t n = points.size;
+  assert(n >= 3);
+
+  if (render_queue.num_points + n > render_queue.points_capacity) {
+    size_t new_capacity = render_queue.points_capacity == 0
+                              ? INITIAL_QUEUE_CAPACITY
+                              : render_queue.points_capacity;
+    while (new_capacity < render_queue.num_points + n) {
+      new_capacity *= QUEUE_GROWTH_FACTOR;
+    }
+    render_queue.x_points = realloc(render_queue.x_points,
+                                    new_capacity * sizeof(int16_t));
+    render_queue.y_points = realloc(render_queue.y_points,
+                                    new_capacity * sizeof(int16_t));
+    assert(render_queue.x_points != NULL);
+    assert(render_queue.y_points != NULL);
+    render_queue.points_capacity = new_capacity;
+  }
+
+  vector_t window_center = get_window_center();
+  size_t first = render_queue.num_points;
+  for (size_t i = 0; i < n; i++) {
+    vector_t pixel = get_window_position(vec_add(points.points[i], offset),
+                                         window_center);
+    render_queue.x_points[first + i] = pixel.x;
+    render_queue.y_points[first + i] = pixel.y;
+  }
+  render_queue.num_points += n;
+  return first;
+}
+
+/**
+ * Appends a command to the render queue, growing the queue if needed.
+ *
+ * @param command the command to append; its seq is filled in here
+ */
+static void render_queue_push(draw_command_t command) {
+  if (render_queue.size >= render_queue.capacity) {
+    size_t new_capacity = render_queue.capacity == 0
+                              ? INITIAL_QUEUE_CAPACITY
+                              : render_queue.capacity * QUEUE_GROWTH_FACTOR;
+    render_queue.commands = realloc(render_queue.commands,
+                                    new_capacity * sizeof(draw_command_t));
+    assert(render_queue.commands != NULL);
+    render_queue.capacity = new_capacity;
+  }
+  command.seq = render_queue.size;
+  render_queue.commands[render_queue.size] = command;
+  render_queue.size++;
+}
+
+/**
+ * Orders draw commands by layer, then by queue order. Textures are not part
+ * of the key: commands in a layer may overlap, e.g. a button's text and its
+ * image, so only runs of one texture queued back to back are drawn together.
+ */
+static int draw_command_compare(const void *a, const void *b) {
+  const draw_command_t *c1 = a;
+  const draw_command_t *c2 = b;
+  if (c1->layer != c2->layer) {
+    return c1->layer < c2->layer ? -1 : 1;
+  }
+  return c1->seq < c2->seq ? -1 : (c1->seq > c2->seq);
+}
+
+/**
+ * Fills a polygon that has already been converted to pixel coordinates.
+ */
+static void draw_pixel_polygon(int16_t *x_points, int16_t *y_points, size_t n,
+                               rgb_color_t color) {
+  filledPolygonRGBA(renderer, x_points, y_points, n, color.r * 255,
+                    color.g * 255, color.b * 255, 255);
+  frame_stats.draw_calls++;
+}
+
+void sdl_queue_image(SDL_Texture *img, SDL_Rect bounds, double rot,
+                     size_t layer) {
+  render_queue_push((draw_command_t){.type = DRAW_IMAGE,
+                                     .layer = layer,
+                                     .texture = img,
+                                     .bounds = bounds,
+                                     .rot = rot});
+}
+
+void sdl_queue_polygon(polygon_t *poly, rgb_color_t color, size_t layer) {
+  sdl_queue_polygon_at(poly, VEC_ZERO, color, layer);
+}
+
+void sdl_queue_polygon_at(polygon_t *poly, vector_t offset, rgb_color_t color,
+                          size_t layer) {
+  size_t n = polygon_get_view(poly).size;
+  size_t first = render_queue_add_points(poly, offset);
+  render_queue_push((draw_command_t){.type = DRAW_POLYGON,
+                                     .layer = layer,
+                                     .texture = NULL,
+                                     .color = color,
+                                     .first_point = first,
+                                     .num_points = n});
+}
+
+void sdl_queue_text(const char *text, TTF_Font *font, rgb_color_t color,
+                    SDL_Rect bounds, size_t layer) {
+  render_queue_push((draw_command_t){.type = DRAW_TEXT,
+                                     .layer = layer,
+                                     .texture = font,
+                                     .bounds = bounds,
+                                     .color = color,
+                                     .text = text});
 }
 
+sdl_frame_stats_t sdl_get_frame_stats(void) { return last_frame_stats; }
+
 void sdl_draw_polygon(polygon_t *poly, rgb_color_t color) {
-  list_t *points = polygon_get_points(poly);
+  shape_view_t points = polygon_get_view(poly);
   // Check parameters
-  size_t n = list_size(points);
+  size_t n = points.size;
   assert(n >= 3);
 
   vector_t window_center = get_window_center();
 
   // Convert each vertex to a point on screen
-  int16_t *x_points = malloc(sizeof(*x_points) * n),
-          *y_points = malloc(sizeof(*y_points) * n);
-  assert(x_points != NULL);
-  assert(y_points != NULL);
+  int16_t *x_points = frame_alloc(sizeof(*x_points) * n),
+          *y_points = frame_alloc(sizeof(*y_points) * n);
   for (size_t i = 0; i < n; i++) {
-    vector_t *vertex = list_get(points, i);
-    vector_t pixel = get_window_position(*vertex, window_center);
+    vector_t pixel = get_window_position(points.points[i], window_center);
     x_points[i] = pixel.x;
     y_points[i] = pixel.y;
   }
 
   // Draw polygon with the given color
-  filledPolygonRGBA(renderer, x_points, y_points, n, color.r * 255,
-                    color.g * 255, color.b * 255, 255);
-  free(x_points);
-  free(y_points);
+  draw_pixel_polygon(x_points, y_points, n, color);
+}
+
+/**
+ * Draws every queued command in sorted order and empties the queue.
+ */
+static void render_queue_flush(void) {
+  qsort(render_queue.commands, render_queue.size, sizeof(draw_command_t),
+        draw_command_compare);
+  for (size_t i = 0; i < render_queue.size; i++) {
+    draw_command_t *command = &render_queue.commands[i];
+    switch (command->type) {
+    case DRAW_IMAGE:
+      if (command->rot != 0) {
+        sdl_draw_image_with_angle(command->texture, command->bounds,
+                                  command->rot);
+      } else {
+        sdl_draw_image(command->texture, command->bounds);
+      }
+      break;
+    case DRAW_POLYGON:
+      draw_pixel_polygon(&render_queue.x_points[command->first_point],
+                         &render_queue.y_points[command->first_point],
+                         command->num_points, command->color);
+      break;
+    case DRAW_TEXT:
+      sdl_draw_text(command->text, command->texture, command->color,
+                    command->bounds);
+      break;
+    }
+  }
+  render_queue.size = 0;
+  render_queue.num_points = 0;
 }
 
 void sdl_show(void) {
+  render_queue_flush();
+
   // Draw boundary lines
   vector_t window_center = get_window_center();
   vector_t max = vec_add(center, max_diff),
            min = vec_subtract(center, max_diff);
   vector_t max_pixel = get_window_position(max, window_center),
            min_pixel = get_window_position(min, window_center);
-  SDL_Rect *boundary = malloc(sizeof(*boundary));
-  boundary->x = min_pixel.x;
-  boundary->y = max_pixel.y;
-  boundary->w = max_pixel.x - min_pixel.x;
-  boundary->h = min_pixel.y - max_pixel.y;
+  SDL_Rect boundary = {
+      .x = min_pixel.x,
+      .y = max_pixel.y,
+      .w = max_pixel.x - min_pixel.x,
+      .h = min_pixel.y - max_pixel.y,
+  };
   SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-  SDL_RenderDrawRect(renderer, boundary);
-  free(boundary);
+  SDL_RenderDrawRect(renderer, &boundary);
   SDL_RenderPresent(renderer);
+  frame_stats.presents++;
 }
 
 void sdl_render_scene(scene_t *scene, void *aux) {
@@ -281,14 +480,11 @@ void sdl_render_scene(scene_t *scene, void *aux) {
   size_t body_count = scene_bodies(scene);
   for (size_t i = 0; i < body_count; i++) {
     body_t *body = scene_get_body(scene, i);
-    list_t *shape = body_get_shape(body);
-    polygon_t *poly = polygon_init(shape, (vector_t){0, 0}, 0, 0, 0, 0);
-    sdl_draw_polygon(poly, *body_get_color(body));
-    list_free(shape);
+    sdl_queue_polygon(body_get_polygon(body), *body_get_color(body), 0);
   }
   if (aux != NULL) {
     body_t *body = aux;
-    sdl_draw_polygon(body_get_polygon(body), *body_get_color(body));
+    sdl_queue_polygon(body_get_polygon(body), *body_get_color(body), 0);
   }
   sdl_show();
 }
@@ -296,11 +492,12 @@ void sdl_render_scene(scene_t *scene, void *aux) {
 void sdl_on_key(key_handler_t handler) { key_handler = handler; }
 
 double time_since_last_tick(void) {
-  clock_t now = clock();
-  double difference = last_clock
-                          ? (double)(now - last_clock) / CLOCKS_PER_SEC
-                          : 0.0; // return 0 the first time this is called
-  last_clock = now;
+  // monotonic wall time; backed by performance.now() under emscripten
+  uint64_t now = SDL_GetPerformanceCounter();
+  double difference =
+      last_counter ? (double)(now - last_counter) / SDL_GetPerformanceFrequency()
+                   : 0.0; // return 0 the first time this is called
+  last_counter = now;
   return difference;
 }
 
@@ -313,10 +510,12 @@ SDL_Texture *load_image(const char *image_path) {
 
 void sdl_draw_image(SDL_Texture *img, SDL_Rect bounds) {
   SDL_RenderCopy(renderer, img, NULL, &bounds);
+  frame_stats.draw_calls++;
 }
 
 void sdl_draw_image_with_angle(SDL_Texture *img, SDL_Rect bounds, double rot) {
   SDL_RenderCopyEx(renderer, img, NULL, &bounds, (-1.0)*(rot*180)/M_PI, NULL, SDL_FLIP_NONE);
+  frame_stats.draw_calls++;
 }
 
 bool sdl_is_mouse_click(void) {
@@ -354,19 +553,18 @@ TTF_Font *load_font(const char *font_style_path, size_t font_size) {
 
 void sdl_draw_text(const char *text, TTF_Font *font, rgb_color_t color,
                    SDL_Rect bounds) {
-  SDL_Color *new_color = malloc(sizeof(SDL_Color));
-  assert(new_color);
-  new_color->r = color.r;
-  new_color->g = color.g;
-  new_color->b = color.b;
+  SDL_Color sdl_color = {.r = color.r, .g = color.g, .b = color.b, .a = 255};
   int w, h;
-  SDL_Surface *text_surface = TTF_RenderText_Solid(font, text, *new_color);
+  SDL_Surface *text_surface = TTF_RenderText_Solid(font, text, sdl_color);
   SDL_Texture *text_texture =
       SDL_CreateTextureFromSurface(renderer, text_surface);
   SDL_QueryTexture(text_texture, NULL, NULL, &w, &h);
   bounds.w = w;
   bounds.h = h;
   SDL_RenderCopy(renderer, text_texture, NULL, &bounds);
+  SDL_DestroyTexture(text_texture);
+  SDL_FreeSurface(text_surface);
+  frame_stats.draw_calls++;
 }
 
 SDL_Rect sdl_get_bounds(size_t h, size_t w, size_t x, size_t y) {
@@ -378,58 +576,33 @@ SDL_Rect sdl_get_bounds(size_t h, size_t w, size_t x, size_t y) {
   return output;
 }
 
-SDL_Rect bounding_box(body_t *body) {
-  list_t *shape = body_get_shape(body);
-  vector_t min = {.x = __DBL_MAX__, .y = __DBL_MAX__};
-  vector_t max = {.x = -__DBL_MAX__, .y = -__DBL_MAX__};
-  for (size_t i = 0; i < list_size(shape); i++) {
-    vector_t p = *(vector_t *)list_get(shape, i);
-    if (p.x < min.x)
-      min.x = p.x;
-    if (p.y < min.y)
-      min.y = p.y;
-    if (p.x > max.x)
-      max.x = p.x;
-    if (p.y > max.y)
-      max.y = p.y;
-  }
-
+SDL_Rect sdl_aabb_to_rect(aabb_t aabb) {
   vector_t MAX = {.x = WINDOW_WIDTH, .y = WINDOW_HEIGHT};
   SDL_Rect box;
-  box.x = (int)min.x;
-  box.y = (int)(MAX.y - max.y);
-  box.w = (int)(max.x - min.x);
-  box.h = (int)(max.y - min.y);
+  box.x = (int)aabb.min.x;
+  box.y = (int)(MAX.y - aabb.max.y);
+  box.w = (int)(aabb.max.x - aabb.min.x);
+  box.h = (int)(aabb.max.y - aabb.min.y);
   return box;
 }
 
+SDL_Rect bounding_box(body_t *body) {
+  return sdl_aabb_to_rect(body_get_aabb(body));
+}
+
+SDL_Rect unrotated_bounding_box(body_t *body) {
+  return sdl_aabb_to_rect(body_get_unrotated_aabb(body));
+}
+
 bool sdl_contained_in_box(double x, double y, SDL_Rect bounding_box) {
   return x >= bounding_box.x && x <= (bounding_box.x + bounding_box.w) &&
          y >= bounding_box.y && y <= (bounding_box.y + bounding_box.h);
 }
 
-list_t *sdl_make_rectangle(double x, double y, double w, double h) {
-  list_t *shape = list_init(NUM_BOX_POINTS, free);
-  vector_t *top_left = malloc(sizeof(vector_t));
-  assert (top_left != NULL);
-  *top_left = (vector_t){x, y};
-  list_add(shape, top_left);
-
-  vector_t *top_right = malloc(sizeof(vector_t));
-  assert (top_right != NULL);
-  *top_right = (vector_t){x + w, y};
-  list_add(shape, top_right);
-
-  vector_t *bottom_right = malloc(sizeof(vector_t));
-  assert (bottom_right != NULL);
-  *bottom_right = (vector_t){x + w, y - h};
-  list_add(shape, bottom_right);
-
-  vector_t *bottom_left = malloc(sizeof(vector_t));
-  assert (bottom_left != NULL);
-  *bottom_left = (vector_t){x, y - h};
-  list_add(shape, bottom_left);
-
-  return shape;
+void sdl_make_rectangle(double x, double y, double w, double h,
+                        vector_t *rect) {
+  rect[0] = (vector_t){x, y};
+  rect[1] = (vector_t){x + w, y};
+  rect[2] = (vector_t){x + w, y - h};
+  rect[3] = (vector_t){x, y - h};
 }
-
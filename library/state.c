@@ -9,6 +9,8 @@
 #include "sdl_wrapper.h"
 #include "level.h"
 #include "state.h"
+#define ALLOC_TAG ALLOC_TAG_LEVEL
+#include "alloc.h"
 
 const size_t REPLAY_BTN_IDX = 0;
 const size_t HOME_BTN_IDX = 1;
@@ -74,10 +76,11 @@ void state_game_over_handler(state_t *state, double x, double y) {
   level_t *removed = state->levels[state->curr_screen - LEVEL_ONE];
   state->levels[state->curr_screen - LEVEL_ONE] = level_init(state->levels_info[state->curr_screen - LEVEL_ONE]);
   state_set_skin(state);
-  free(removed);
+  level_free(removed);
 
   // replay
   if (index == REPLAY_BTN_IDX) {
+    level_enter(state_current_level(state));
     return;
   }
 
@@ -95,6 +98,7 @@ void state_game_over_handler(state_t *state, double x, double y) {
     }
     else {
       state->curr_screen = state_get_screen(state) + 1; // go to next level
+      level_enter(state_current_level(state));
     }
   }
 }
@@ -127,6 +131,7 @@ void state_start_screen_handler(state_t *state, double x, double y) {
   state->curr_screen = (size_t)(level_get_start_button_index_clicked(x, y) + SKIN_SCREEN);
   if (state->curr_screen > SKIN_SCREEN) {
     sdl_set_music_volume(LEVEL_VOLUME);
+    level_enter(state_current_level(state));
   }
 }
 
@@ -0,0 +1,230 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "thread_pool.h"
+
+// emscripten only has threads when built with -pthread
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define THREAD_POOL_SERIAL
+#else
+#include <pthread.h>
+#endif
+
+#define ALLOC_TAG ALLOC_TAG_CORE
+#include "alloc.h"
+
+#ifndef THREAD_POOL_SERIAL
+
+/**
+ * The chunks dealt to a worker that are yet to run, [next, end).
+ * The worker takes chunks from the front and thieves from the back.
+ */
+typedef struct worker_queue {
+  pthread_mutex_t lock;
+  size_t next;
+  size_t end;
+} worker_queue_t;
+
+/**
+ * The argument passed to a worker thread.
+ */
+typedef struct worker {
+  thread_pool_t *pool;
+  size_t id;
+} worker_t;
+
+#endif
+
+struct thread_pool {
+  size_t num_workers;
+#ifndef THREAD_POOL_SERIAL
+  // worker 0 is the thread that calls thread_pool_parallel_for()
+  pthread_t *threads;
+  worker_t *workers;
+  worker_queue_t *queues;
+  pthread_mutex_t lock;
+  pthread_cond_t work_ready;
+  pthread_cond_t work_done;
+  // counts the loops run, so a waking worker knows whether there is work
+  size_t round;
+  size_t num_running;
+  bool stopping;
+  // the loop being run
+  parallel_task_t task;
+  void *aux;
+  size_t count;
+  size_t chunk_size;
+#endif
+};
+
+static void run_serial(size_t count, size_t chunk_size, parallel_task_t task,
+                       void *aux) {
+  for (size_t begin = 0; begin < count; begin += chunk_size) {
+    size_t end = begin + chunk_size < count ? begin + chunk_size : count;
+    task(aux, begin, end);
+  }
+}
+
+#ifndef THREAD_POOL_SERIAL
+
+static bool pop_chunk(worker_queue_t *queue, bool from_back, size_t *chunk) {
+  pthread_mutex_lock(&queue->lock);
+  bool found = queue->next < queue->end;
+  if (found) {
+    *chunk = from_back ? --queue->end : queue->next++;
+  }
+  pthread_mutex_unlock(&queue->lock);
+  return found;
+}
+
+static void run_chunk(thread_pool_t *pool, size_t chunk) {
+  size_t begin = chunk * pool->chunk_size;
+  size_t end = begin + pool->chunk_size < pool->count
+                   ? begin + pool->chunk_size
+                   : pool->count;
+  pool->task(pool->aux, begin, end);
+}
+
+/**
+ * Runs the worker's own chunks, then steals chunks from the other workers
+ * until every queue is empty. No chunks are added during a loop, so a queue
+ * that has been emptied stays empty.
+ */
+static void work(thread_pool_t *pool, size_t id) {
+  size_t chunk;
+  while (pop_chunk(&pool->queues[id], false, &chunk)) {
+    run_chunk(pool, chunk);
+  }
+  for (size_t i = 1; i < pool->num_workers; i++) {
+    worker_queue_t *victim = &pool->queues[(id + i) % pool->num_workers];
+    while (pop_chunk(victim, true, &chunk)) {
+      run_chunk(pool, chunk);
+    }
+  }
+}
+
+static void *worker_main(void *arg) {
+  worker_t *worker = arg;
+  thread_pool_t *pool = worker->pool;
+  size_t seen_round = 0;
+  pthread_mutex_lock(&pool->lock);
+  while (true) {
+    while (!pool->stopping && pool->round == seen_round) {
+      pthread_cond_wait(&pool->work_ready, &pool->lock);
+    }
+    if (pool->stopping) {
+      break;
+    }
+    seen_round = pool->round;
+    pthread_mutex_unlock(&pool->lock);
+
+    work(pool, worker->id);
+
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->num_running == 0) {
+      pthread_cond_signal(&pool->work_done);
+    }
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+#endif
+
+thread_pool_t *thread_pool_init(size_t num_workers) {
+  assert(num_workers > 0);
+  thread_pool_t *pool = malloc(sizeof(thread_pool_t));
+  assert(pool != NULL);
+#ifdef THREAD_POOL_SERIAL
+  pool->num_workers = 1;
+#else
+  pool->num_workers = num_workers;
+  pool->threads = malloc(num_workers * sizeof(pthread_t));
+  pool->workers = malloc(num_workers * sizeof(worker_t));
+  pool->queues = malloc(num_workers * sizeof(worker_queue_t));
+  assert(pool->threads != NULL);
+  assert(pool->workers != NULL);
+  assert(pool->queues != NULL);
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->work_ready, NULL);
+  pthread_cond_init(&pool->work_done, NULL);
+  pool->round = 0;
+  pool->num_running = 0;
+  pool->stopping = false;
+  for (size_t i = 0; i < num_workers; i++) {
+    pthread_mutex_init(&pool->queues[i].lock, NULL);
+    pool->queues[i].next = 0;
+    pool->queues[i].end = 0;
+    pool->workers[i] = (worker_t){.pool = pool, .id = i};
+  }
+  for (size_t i = 1; i < num_workers; i++) {
+    int error = pthread_create(&pool->threads[i], NULL, worker_main,
+                               &pool->workers[i]);
+    assert(error == 0);
+  }
+#endif
+  return pool;
+}
+
+void thread_pool_free(thread_pool_t *pool) {
+#ifndef THREAD_POOL_SERIAL
+  pthread_mutex_lock(&pool->lock);
+  pool->stopping = true;
+  pthread_cond_broadcast(&pool->work_ready);
+  pthread_mutex_unlock(&pool->lock);
+  for (size_t i = 1; i < pool->num_workers; i++) {
+    pthread_join(pool->threads[i], NULL);
+  }
+  for (size_t i = 0; i < pool->num_workers; i++) {
+    pthread_mutex_destroy(&pool->queues[i].lock);
+  }
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->work_ready);
+  pthread_cond_destroy(&pool->work_done);
+  free(pool->threads);
+  free(pool->workers);
+  free(pool->queues);
+#endif
+  free(pool);
+}
+
+size_t thread_pool_num_workers(thread_pool_t *pool) {
+  return pool->num_workers;
+}
+
+void thread_pool_parallel_for(thread_pool_t *pool, size_t count,
+                              size_t chunk_size, parallel_task_t task,
+                              void *aux) {
+  assert(chunk_size > 0);
+  size_t num_chunks = (count + chunk_size - 1) / chunk_size;
+  if (pool == NULL || pool->num_workers == 1 || num_chunks <= 1) {
+    run_serial(count, chunk_size, task, aux);
+    return;
+  }
+#ifndef THREAD_POOL_SERIAL
+  size_t n = pool->num_workers;
+  pthread_mutex_lock(&pool->lock);
+  pool->task = task;
+  pool->aux = aux;
+  pool->count = count;
+  pool->chunk_size = chunk_size;
+  // deal out contiguous runs of chunks, so neighbouring chunks share a worker
+  for (size_t i = 0; i < n; i++) {
+    pool->queues[i].next = num_chunks * i / n;
+    pool->queues[i].end = num_chunks * (i + 1) / n;
+  }
+  pool->num_running = n - 1;
+  pool->round++;
+  pthread_cond_broadcast(&pool->work_ready);
+  pthread_mutex_unlock(&pool->lock);
+
+  work(pool, 0);
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->num_running > 0) {
+    pthread_cond_wait(&pool->work_done, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+#endif
+}
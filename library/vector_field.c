@@ -0,0 +1,82 @@
+#include "vector_field.h"
+
+#include <assert.h>
+#include <math.h>
+
+/**
+ * Converts a coordinate to a grid cell and the fraction of the way across
+ * it, clamping to the edges of the grid.
+ *
+ * @param coordinate the position along the axis, in samples from the origin
+ * @param last_cell the index of the last cell, which starts one sample
+ *   before the last sample (0 if there is only one sample)
+ * @param cell filled in with the index of the cell containing the position
+ * @return the fraction of the way across the cell, in [0, 1]
+ */
+static double locate(double coordinate, size_t last_cell, size_t *cell) {
+  double end = (double)(last_cell + 1);
+  double clamped = coordinate < 0 ? 0 : coordinate > end ? end : coordinate;
+  // truncation is floor for non-negative values
+  size_t index = (size_t)clamped;
+  *cell = index < last_cell ? index : last_cell;
+  return clamped - (double)*cell;
+}
+
+/**
+ * Interpolates along a row between two neighbouring samples, with each
+ * sample blended between two frames.
+ */
+static inline vector_t lerp_frames(const vector_t *current,
+                                   const vector_t *next, double blend,
+                                   size_t left, size_t right, double u) {
+  vector_t a = {current[left].x + blend * (next[left].x - current[left].x),
+                current[left].y + blend * (next[left].y - current[left].y)};
+  vector_t b = {current[right].x + blend * (next[right].x - current[right].x),
+                current[right].y + blend * (next[right].y - current[right].y)};
+  return (vector_t){a.x + u * (b.x - a.x), a.y + u * (b.y - a.y)};
+}
+
+void vector_field_sample(const vector_field_t *field, double time,
+                         const double *x, const double *y, double *out_x,
+                         double *out_y, size_t size) {
+  assert(field->columns > 0 && field->rows > 0 && field->num_frames > 0);
+  size_t frame_size = field->columns * field->rows;
+  size_t column_step = field->columns > 1 ? 1 : 0;
+  size_t row_step = field->rows > 1 ? field->columns : 0;
+
+  // the two frames to blend are the same for every position
+  double frame_time = field->num_frames > 1 ? time / field->frame_duration : 0;
+  double frame_index = floor(frame_time);
+  double blend = frame_time - frame_index;
+  size_t frame = (size_t)fmod(frame_index, (double)field->num_frames);
+  const vector_t *current = &field->samples[frame * frame_size];
+  const vector_t *next =
+      &field->samples[(frame + 1) % field->num_frames * frame_size];
+
+  // a grid one sample wide has a single cell, whose far side is its near side
+  size_t last_column = field->columns > 1 ? field->columns - 2 : 0;
+  size_t last_row = field->rows > 1 ? field->rows - 2 : 0;
+  double inv_spacing = 1 / field->spacing;
+  for (size_t i = 0; i < size; i++) {
+    size_t column, row;
+    double u = locate((x[i] - field->origin.x) * inv_spacing, last_column,
+                      &column);
+    double v = locate((y[i] - field->origin.y) * inv_spacing, last_row, &row);
+    size_t bottom_left = row * field->columns + column;
+    size_t top_left = bottom_left + row_step;
+    vector_t bottom = lerp_frames(current, next, blend, bottom_left,
+                                  bottom_left + column_step, u);
+    vector_t top = lerp_frames(current, next, blend, top_left,
+                               top_left + column_step, u);
+    out_x[i] = bottom.x + v * (top.x - bottom.x);
+    out_y[i] = bottom.y + v * (top.y - bottom.y);
+  }
+}
+
+vector_t vector_field_at(const vector_field_t *field, double time,
+                         vector_t position) {
+  vector_t value;
+  vector_field_sample(field, time, &position.x, &position.y, &value.x,
+                      &value.y, 1);
+  return value;
+}